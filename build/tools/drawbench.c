@@ -0,0 +1,323 @@
+// MIT License
+
+// Copyright (c) 2020 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// times the filled primitives against a per pixel poke4 reference loop and
+// checks the framebuffer hashes against the reference and against
+// draw.golden, which was recorded with the old pixel by pixel fill:
+//   drawbench [-iterations <n>] [-golden <file> [-update]]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "api.h"
+#include "tools.h"
+
+#if defined(DRAWBENCH_GOLDEN)
+#define DEFAULT_GOLDEN DRAWBENCH_GOLDEN
+#else
+#define DEFAULT_GOLDEN NULL
+#endif
+
+// how many calls are drawn before the framebuffer is hashed
+#define HASH_CALLS 64
+
+typedef struct
+{
+	s32 l, t, r, b;
+} Clip;
+
+typedef struct
+{
+	const char* name;
+	void(*draw)(tic_mem* tic, s32 index);
+	void(*reference)(tic_mem* tic, const Clip* clip, s32 index);
+	Clip clip;
+} Case;
+
+typedef struct
+{
+	u32 hash;
+	double ns;
+} Result;
+
+static u64 now()
+{
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return (u64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static u8 mapColor(tic_mem* tic, u8 color)
+{
+	return tic_tool_peek4(tic->ram->vram.mapping, color & 0xf);
+}
+
+// the fill loop every span went through before fillSpan()
+static void pokeRect(tic_mem* tic, const Clip* clip, s32 x, s32 y, s32 width, s32 height, u8 color)
+{
+	color = mapColor(tic, color);
+
+	for(s32 i = y; i < y + height; ++i)
+	{
+		if(i < clip->t || clip->b <= i) continue;
+
+		s32 xl = MAX(x, clip->l);
+		s32 xr = MIN(x + width, clip->r);
+		s32 start = i * TIC80_WIDTH;
+
+		for(s32 p = start + xl, end = start + xr; p < end; ++p)
+			tic_api_poke4(tic, p, color);
+	}
+}
+
+static u32 rnd(u32* seed)
+{
+	return *seed = *seed * 1103515245 + 12345, *seed >> 16;
+}
+
+static void rectDraw(tic_mem* tic, s32 index)
+{
+	tic_api_rect(tic, 0, 0, TIC80_WIDTH, TIC80_HEIGHT, index);
+}
+
+static void rectRef(tic_mem* tic, const Clip* clip, s32 index)
+{
+	pokeRect(tic, clip, 0, 0, TIC80_WIDTH, TIC80_HEIGHT, index);
+}
+
+// odd positions and sizes, so both edge nibbles are poked
+static void rectOddDraw(tic_mem* tic, s32 index)
+{
+	tic_api_rect(tic, index % 7 - 3, index % 5 + 1, 151 + index % 3, 81, index);
+}
+
+static void rectOddRef(tic_mem* tic, const Clip* clip, s32 index)
+{
+	pokeRect(tic, clip, index % 7 - 3, index % 5 + 1, 151 + index % 3, 81, index);
+}
+
+static void clsDraw(tic_mem* tic, s32 index)
+{
+	tic_api_cls(tic, index);
+}
+
+static void clsRef(tic_mem* tic, const Clip* clip, s32 index)
+{
+	pokeRect(tic, clip, clip->l, clip->t, clip->r - clip->l, clip->b - clip->t, index);
+}
+
+static void circDraw(tic_mem* tic, s32 index)
+{
+	tic_api_circ(tic, TIC80_WIDTH / 2, TIC80_HEIGHT / 2, 60 + index % 3, index);
+}
+
+static void elliDraw(tic_mem* tic, s32 index)
+{
+	tic_api_elli(tic, TIC80_WIDTH / 2 + index % 2, TIC80_HEIGHT / 2, 100 + index % 5, 50, index);
+}
+
+static void triDraw(tic_mem* tic, s32 index)
+{
+	tic_api_tri(tic, 0, 0, TIC80_WIDTH - 1, 10, 100 + index % 7, TIC80_HEIGHT - 1, index);
+}
+
+static void triSmallDraw(tic_mem* tic, s32 index)
+{
+	s32 x = index * 37 % 200, y = index * 13 % 100;
+	tic_api_tri(tic, x, y, x + 20, y + 5, x + 7, y + 20, index);
+}
+
+// random filled and outlined primitives under random clip rects
+static void mixDraw(tic_mem* tic, s32 index)
+{
+	u32 seed = index;
+
+	if(index % 16 == 0)
+		tic_api_clip(tic, rnd(&seed) % 60 - 10, rnd(&seed) % 40 - 10, rnd(&seed) % 260, rnd(&seed) % 160);
+
+	s32 x = rnd(&seed) % 280 - 20, y = rnd(&seed) % 176 - 20;
+	s32 w = rnd(&seed) % 120, h = rnd(&seed) % 80;
+	u8 color = rnd(&seed);
+
+	switch(rnd(&seed) % 9)
+	{
+	case 0: tic_api_rect(tic, x, y, w, h, color); break;
+	case 1: tic_api_rectb(tic, x, y, w, h, color); break;
+	case 2: tic_api_circ(tic, x, y, w / 2, color); break;
+	case 3: tic_api_circb(tic, x, y, w / 2, color); break;
+	case 4: tic_api_elli(tic, x, y, w / 2, h / 2, color); break;
+	case 5: tic_api_ellib(tic, x, y, w / 2, h / 2, color); break;
+	case 6: tic_api_tri(tic, x, y, x + w, y + h / 3, x + w / 4, y + h, color); break;
+	case 7: tic_api_line(tic, x, y, x + w, y + h, color); break;
+	case 8: tic_api_cls(tic, color); break;
+	}
+}
+
+static u32 hashScreen(tic_mem* tic)
+{
+	// FNV-1a
+	u32 hash = 2166136261u;
+	const u8* data = tic->ram->vram.screen.data;
+
+	for(s32 i = 0; i < sizeof(tic_screen); i++)
+		hash = (hash ^ data[i]) * 16777619u;
+
+	return hash;
+}
+
+static void setClip(tic_mem* tic, const Clip* clip)
+{
+	tic_api_clip(tic, 0, 0, TIC80_WIDTH, TIC80_HEIGHT);
+	tic_api_cls(tic, 0);
+	tic_api_clip(tic, clip->l, clip->t, clip->r - clip->l, clip->b - clip->t);
+}
+
+static Result run(tic_mem* tic, const Case* test, s32 iterations, bool reference)
+{
+	setClip(tic, &test->clip);
+
+	for(s32 i = 0; i < HASH_CALLS; i++)
+		reference
+			? test->reference(tic, &test->clip, i)
+			: test->draw(tic, i);
+
+	u32 hash = hashScreen(tic);
+
+	setClip(tic, &test->clip);
+
+	u64 start = now();
+
+	for(s32 i = 0; i < iterations; i++)
+		reference
+			? test->reference(tic, &test->clip, i)
+			: test->draw(tic, i);
+
+	return (Result){hash, (double)(now() - start) / iterations};
+}
+
+static bool findGolden(FILE* file, const char* name, u32* hash)
+{
+	char line[256], key[128];
+
+	if(file)
+	{
+		rewind(file);
+
+		while(fgets(line, sizeof line, file))
+			if(sscanf(line, "%127s %x", key, hash) == 2 && strcmp(key, name) == 0)
+				return true;
+	}
+
+	return false;
+}
+
+int main(int argc, char** argv)
+{
+	s32 iterations = 10000;
+	const char* golden = DEFAULT_GOLDEN;
+	bool update = false;
+
+	enum{W = TIC80_WIDTH, H = TIC80_HEIGHT};
+
+	static const Case Cases[] =
+	{
+		{"rect",            rectDraw,       rectRef,    {0, 0, W, H}},
+		{"rect-odd",        rectOddDraw,    rectOddRef, {0, 0, W, H}},
+		{"rect-clipped",    rectDraw,       rectRef,    {3, 2, W - 5, H - 3}},
+		{"cls-clipped",     clsDraw,        clsRef,     {1, 1, W - 1, H - 1}},
+		{"circ",            circDraw,       NULL,       {0, 0, W, H}},
+		{"circ-clipped",    circDraw,       NULL,       {71, 20, 167, H - 9}},
+		{"elli",            elliDraw,       NULL,       {0, 0, W, H}},
+		{"tri",             triDraw,        NULL,       {0, 0, W, H}},
+		{"tri-small",       triSmallDraw,   NULL,       {0, 0, W, H}},
+		{"mix",             mixDraw,        NULL,       {0, 0, W, H}},
+	};
+
+	for(s32 i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "-iterations") == 0 && i + 1 < argc)
+			iterations = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-golden") == 0 && i + 1 < argc)
+			golden = argv[++i];
+		else if(strcmp(argv[i], "-update") == 0)
+			update = true;
+		else iterations = 0;
+	}
+
+	if(iterations <= 0)
+	{
+		printf("usage: drawbench [-iterations <n>] [-golden <file> [-update]]\n");
+		return -1;
+	}
+
+	FILE* goldenFile = golden ? fopen(golden, update ? "w" : "r") : NULL;
+
+	if(golden && !goldenFile)
+	{
+		printf("cannot open golden file %s\n", golden);
+		return -1;
+	}
+
+	tic_mem* tic = tic_core_create(44100, TIC80_PIXEL_COLOR_RGBA8888, TIC80_LATENCY_DEFAULT);
+	s32 failed = 0;
+
+	printf("%-16s %10s %10s %8s %s\n", "case", "poke4 ns", "api ns", "hash", "result");
+
+	for(s32 i = 0; i < COUNT_OF(Cases); i++)
+	{
+		const Case* test = &Cases[i];
+
+		Result api = run(tic, test, iterations, false);
+		Result ref = test->reference ? run(tic, test, iterations, true) : (Result){api.hash, 0};
+
+		const char* result = "ok";
+		u32 expected;
+
+		if(ref.hash != api.hash)
+			result = "FAIL differs from poke4";
+		else if(goldenFile && update)
+			fprintf(goldenFile, "%s %08x\n", test->name, api.hash);
+		else if(goldenFile && !findGolden(goldenFile, test->name, &expected))
+			result = "no golden hash";
+		else if(goldenFile && expected != api.hash)
+			result = "FAIL golden hash differs";
+
+		if(strncmp(result, "FAIL", 4) == 0)
+			failed++;
+
+		if(test->reference)
+			printf("%-16s %10.0f %10.0f %08x %s\n", test->name, ref.ns, api.ns, api.hash, result);
+		else
+			printf("%-16s %10s %10.0f %08x %s\n", test->name, "-", api.ns, api.hash, result);
+	}
+
+	tic_core_close(tic);
+
+	if(goldenFile)
+		fclose(goldenFile);
+
+	printf("%d cases, %d iterations each, %d failed\n", (s32)COUNT_OF(Cases), iterations, failed);
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,392 @@
+// MIT License
+
+// Copyright (c) 2020 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// times the sound tick and synth over synthetic register patterns and the
+// music and sfx of the given projects, renders every case with both synths
+// and compares the PCM hashes with each other and with a golden file; the
+// cmake build runs the demos against sound.golden when no arguments are given:
+//   soundbench [-frames <n>] [-golden <file> [-update]] [projects...]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "api.h"
+#include "tools.h"
+#include "studio/project.h"
+
+#define SAMPLERATE 44100
+
+#if defined(SOUNDBENCH_GOLDEN)
+#define DEFAULT_GOLDEN SOUNDBENCH_GOLDEN
+#else
+#define DEFAULT_GOLDEN NULL
+#endif
+
+#if defined(SOUNDBENCH_DEMOS)
+#define DEFAULT_DEMOS SOUNDBENCH_DEMOS
+#else
+#define DEFAULT_DEMOS NULL
+#endif
+
+// the demos with music or sfx, they are used when no projects are given
+static const char* const Demos[] = {"music.lua", "sfx.lua", "luademo.lua"};
+
+typedef struct
+{
+	char name[64];
+	void(*frame)(tic_mem* tic, s32 frame, s32 param);
+	s32 param;
+	const tic_cartridge* cart;
+} Case;
+
+typedef struct
+{
+	u32 hash;
+	double ns;
+} Result;
+
+static u64 now()
+{
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return (u64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// 8 pulse widths (none of them flat, a flat wave is noise), saw up and down, triangle, sine-ish and 4 noisy tables
+static void makeWave(tic_waveform* wave, s32 index)
+{
+	static const u8 Sine[WAVE_VALUES] = {8,9,11,12,13,14,15,15,15,15,15,14,13,12,11,9,8,6,4,3,2,1,0,0,0,0,0,1,2,3,4,6};
+
+	u32 seed = index * 2654435761u;
+
+	for(s32 i = 0; i < WAVE_VALUES; i++)
+	{
+		s32 value;
+
+		if(index < 8) value = i < index * 4 + 2 ? MAX_VOLUME : 0;
+		else if(index == 8) value = i / 2;
+		else if(index == 9) value = MAX_VOLUME - i / 2;
+		else if(index == 10) value = i < 16 ? i : 31 - i;
+		else if(index == 11) value = Sine[i];
+		else value = (seed = seed * 1103515245 + 12345) >> 28;
+
+		tic_tool_poke4(wave->data, i, value);
+	}
+}
+
+static void setChannel(tic_mem* tic, s32 channel, s32 freq, s32 volume, s32 left, s32 right)
+{
+	tic_sound_register* reg = &tic->ram->registers[channel];
+
+	tic_sound_register_set_freq(reg, freq);
+	reg->volume = volume;
+
+	tic_tool_poke4(&tic->ram->stereo.data, channel * 2, left);
+	tic_tool_poke4(&tic->ram->stereo.data, channel * 2 + 1, right);
+}
+
+// sweeps all 12 bits of the frequency every 256 frames
+static s32 sweep(s32 frame)
+{
+	return (frame * 16) & 0xfff;
+}
+
+static void waveFrame(tic_mem* tic, s32 frame, s32 param)
+{
+	makeWave(&tic->ram->registers[0].waveform, param);
+	setChannel(tic, 0, sweep(frame), MAX_VOLUME, MAX_VOLUME, MAX_VOLUME);
+}
+
+// an all 0 or all 0xff waveform is noise, with short and long feedback
+static void noiseFrame(tic_mem* tic, s32 frame, s32 param)
+{
+	memset(tic->ram->registers[0].waveform.data, param, sizeof(tic_waveform));
+	setChannel(tic, 0, sweep(frame), MAX_VOLUME, MAX_VOLUME, MAX_VOLUME);
+}
+
+static void stereoFrame(tic_mem* tic, s32 frame, s32 param)
+{
+	for(s32 c = 0; c < TIC_SOUND_CHANNELS; c++)
+	{
+		makeWave(&tic->ram->registers[c].waveform, c * 3);
+		setChannel(tic, c, 100 + c * 300, MAX_VOLUME, param ? 0 : MAX_VOLUME - c, param ? MAX_VOLUME - c : 0);
+	}
+}
+
+static void extremeFrame(tic_mem* tic, s32 frame, s32 param)
+{
+	static const s32 Freqs[] = {0, 1, 2, 4095};
+
+	for(s32 c = 0; c < TIC_SOUND_CHANNELS; c++)
+	{
+		makeWave(&tic->ram->registers[c].waveform, c == 3 ? 11 : c);
+		setChannel(tic, c, Freqs[(c + frame / 60) % COUNT_OF(Freqs)], (frame + c) % (MAX_VOLUME + 1), MAX_VOLUME, MAX_VOLUME);
+	}
+}
+
+// 4 channels with volume, pan and wave changing every frame
+static void mixFrame(tic_mem* tic, s32 frame, s32 param)
+{
+	for(s32 c = 0; c < TIC_SOUND_CHANNELS; c++)
+	{
+		if(c == 3) memset(tic->ram->registers[c].waveform.data, 0, sizeof(tic_waveform));
+		else makeWave(&tic->ram->registers[c].waveform, (frame / 30 + c * 5) % 16);
+
+		setChannel(tic, c, 200 + c * 150 + frame % 50, (frame * (c + 1)) % (MAX_VOLUME + 1), frame % 16, 15 - frame % 16);
+	}
+}
+
+static void musicFrame(tic_mem* tic, s32 frame, s32 param)
+{
+	if(tic->ram->music_state.flag.music_status == tic_music_stop)
+		tic_api_music(tic, param, -1, -1, true, false, -1, -1);
+}
+
+// plays the sfx with its own note and speed, like sfx(id) does
+static void sfxFrame(tic_mem* tic, s32 frame, s32 param)
+{
+	const tic_sample* effect = &tic->ram->sfx.samples.data[param];
+
+	if(frame == 0)
+		tic_api_sfx(tic, param, effect->note, effect->octave, -1, 0, MAX_VOLUME, MAX_VOLUME, effect->speed);
+}
+
+static Result run(const Case* test, s32 frames, tic_synth synth)
+{
+	tic_mem* tic = tic_core_create(SAMPLERATE, TIC80_PIXEL_COLOR_RGBA8888, TIC80_LATENCY_DEFAULT);
+	tic_core_synth(tic, synth);
+
+	if(test->cart)
+	{
+		memcpy(&tic->cart, test->cart, sizeof(tic_cartridge));
+		tic_api_sync(tic, tic_sync_sfx | tic_sync_music, 0, false);
+	}
+
+	// FNV-1a over the little endian PCM
+	u32 hash = 2166136261u;
+	u64 time = 0;
+
+	for(s32 i = 0; i < frames; i++)
+	{
+		u64 start = now();
+
+		tic_core_sound_tick_start(tic);
+		test->frame(tic, i, test->param);
+		tic_core_sound_tick_end(tic);
+		tic_core_synth_sound(tic);
+
+		time += now() - start;
+
+		const s16* samples = tic->product.samples.buffer;
+		for(s32 s = 0; s < tic->product.samples.count; s++)
+		{
+			hash = (hash ^ (samples[s] & 0xff)) * 16777619u;
+			hash = (hash ^ ((u16)samples[s] >> 8)) * 16777619u;
+		}
+	}
+
+	tic_core_close(tic);
+
+	return (Result){hash, (double)time / frames};
+}
+
+static tic_cartridge* loadProject(const char* path)
+{
+	tic_cartridge* cart = NULL;
+	FILE* file = fopen(path, "rb");
+
+	if(file)
+	{
+		fseek(file, 0, SEEK_END);
+		s32 size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+
+		char* buffer = malloc(size);
+
+		if(buffer && fread(buffer, size, 1, file) == 1)
+		{
+			cart = calloc(1, sizeof(tic_cartridge));
+
+			if(!tic_project_load(path, buffer, size, cart))
+			{
+				free(cart);
+				cart = NULL;
+			}
+		}
+
+		free(buffer);
+		fclose(file);
+	}
+
+	return cart;
+}
+
+// a case for every track and sfx of the project
+static bool addProject(Case* cases, s32* count, s32 max, const char* path)
+{
+	tic_cartridge* cart = loadProject(path);
+
+	if(!cart)
+	{
+		printf("cannot load project %s\n", path);
+		return false;
+	}
+
+	const char* name = strrchr(path, '/');
+	name = name ? name + 1 : path;
+
+	for(s32 t = 0; t < MUSIC_TRACKS && *count < max; t++)
+		if(!EMPTY(cart->bank0.music.tracks.data[t].data))
+		{
+			cases[*count] = (Case){"", musicFrame, t, cart};
+			snprintf(cases[*count].name, sizeof cases[*count].name, "%s:%d", name, t);
+			(*count)++;
+		}
+
+	for(s32 s = 0; s < SFX_COUNT && *count < max; s++)
+		if(!tic_tool_empty(&cart->bank0.sfx.samples.data[s], sizeof(tic_sample)))
+		{
+			cases[*count] = (Case){"", sfxFrame, s, cart};
+			snprintf(cases[*count].name, sizeof cases[*count].name, "%s:sfx%d", name, s);
+			(*count)++;
+		}
+
+	return true;
+}
+
+static bool findGolden(FILE* file, const char* name, u32* hash)
+{
+	char line[256], key[128];
+
+	if(file)
+	{
+		rewind(file);
+
+		while(fgets(line, sizeof line, file))
+			if(sscanf(line, "%127s %x", key, hash) == 2 && strcmp(key, name) == 0)
+				return true;
+	}
+
+	return false;
+}
+
+int main(int argc, char** argv)
+{
+	s32 frames = 600;
+	const char* golden = DEFAULT_GOLDEN;
+	bool update = false;
+
+	enum{MaxCases = 64 + (MUSIC_TRACKS + SFX_COUNT) * 16};
+	static Case cases[MaxCases];
+	s32 count = 0;
+
+	for(s32 i = 0; i < 16; i++)
+		cases[count++] = (Case){"", waveFrame, i}, sprintf(cases[count - 1].name, "wave%02d", i);
+
+	cases[count++] = (Case){"noise-long", noiseFrame, 0x00};
+	cases[count++] = (Case){"noise-short", noiseFrame, 0xff};
+	cases[count++] = (Case){"stereo-left", stereoFrame, 0};
+	cases[count++] = (Case){"stereo-right", stereoFrame, 1};
+	cases[count++] = (Case){"extreme", extremeFrame, 0};
+	cases[count++] = (Case){"mix", mixFrame, 0};
+
+	bool projects = false;
+
+	for(s32 i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+			frames = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-golden") == 0 && i + 1 < argc)
+			golden = argv[++i];
+		else if(strcmp(argv[i], "-update") == 0)
+			update = true;
+		else if(addProject(cases, &count, MaxCases, argv[i]))
+			projects = true;
+		else return -1;
+	}
+
+	const char* demos = DEFAULT_DEMOS;
+
+	for(s32 i = 0; i < COUNT_OF(Demos) && demos && !projects; i++)
+	{
+		char path[256];
+		snprintf(path, sizeof path, "%s/%s", demos, Demos[i]);
+
+		if(!addProject(cases, &count, MaxCases, path))
+			return -1;
+	}
+
+	if(frames <= 0)
+	{
+		printf("usage: soundbench [-frames <n>] [-golden <file> [-update]] [projects...]\n");
+		return -1;
+	}
+
+	FILE* goldenFile = golden ? fopen(golden, update ? "w" : "r") : NULL;
+
+	if(golden && !goldenFile)
+	{
+		printf("cannot open golden file %s\n", golden);
+		return -1;
+	}
+
+	s32 failed = 0;
+
+	printf("%-24s %10s %10s %8s %s\n", "case", "step ns", "block ns", "hash", "result");
+
+	for(s32 i = 0; i < count; i++)
+	{
+		const Case* test = &cases[i];
+
+		Result step = run(test, frames, tic_synth_step);
+		Result block = run(test, frames, tic_synth_block);
+
+		const char* result = "ok";
+		u32 expected;
+
+		// the hashes depend on the frame count
+		char key[sizeof test->name + 16];
+		snprintf(key, sizeof key, "%.63s/%d", test->name, frames);
+
+		if(step.hash != block.hash)
+			result = "FAIL synths differ";
+		else if(goldenFile && update)
+			fprintf(goldenFile, "%s %08x\n", key, block.hash);
+		else if(goldenFile && !findGolden(goldenFile, key, &expected))
+			result = "no golden hash";
+		else if(goldenFile && expected != block.hash)
+			result = "FAIL golden hash differs";
+
+		if(strncmp(result, "FAIL", 4) == 0)
+			failed++;
+
+		printf("%-24s %10.0f %10.0f %08x %s\n", test->name, step.ns, block.ns, block.hash, result);
+	}
+
+	if(goldenFile)
+		fclose(goldenFile);
+
+	printf("%d cases, %d frames each, %d failed\n", count, frames, failed);
+
+	return failed ? 1 : 0;
+}
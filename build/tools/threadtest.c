@@ -0,0 +1,253 @@
+// MIT License
+
+// Copyright (c) 2020 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// ticks the same randomized draw and sound workload on one core per thread
+// and checks that every thread produces the frames of a single threaded run:
+//   threadtest [-threads <n>] [-frames <n>]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "api.h"
+#include "tools.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#define SEED 0x1234567
+
+typedef struct
+{
+	s32 frames;
+	u32 video;
+	u32 audio;
+} Job;
+
+static u32 rnd(u32* seed)
+{
+	return *seed = *seed * 1103515245 + 12345, *seed >> 16;
+}
+
+static u32 hash(u32 hash, const void* data, s32 size)
+{
+	// FNV-1a
+	for(const u8 *ptr = data, *end = ptr + size; ptr < end; ptr++)
+		hash = (hash ^ *ptr) * 16777619u;
+
+	return hash;
+}
+
+// random primitives touching all the rasterizer scratch state: the
+// remapped transparent colors, the sides buffer and the ttri depth buffer
+static void drawFrame(tic_mem* tic, u32* seed)
+{
+	for(s32 i = 0; i < 64; i++)
+	{
+		s32 x = rnd(seed) % 280 - 20, y = rnd(seed) % 176 - 20;
+		s32 w = rnd(seed) % 100, h = rnd(seed) % 60;
+		u8 color = rnd(seed);
+		u8 trans[] = {rnd(seed) & 0xf, rnd(seed) & 0xf};
+
+		switch(rnd(seed) % 12)
+		{
+		case 0: tic_api_rect(tic, x, y, w, h, color); break;
+		case 1: tic_api_rectb(tic, x, y, w, h, color); break;
+		case 2: tic_api_circ(tic, x, y, w / 2, color); break;
+		case 3: tic_api_circb(tic, x, y, w / 2, color); break;
+		case 4: tic_api_elli(tic, x, y, w / 2, h / 2, color); break;
+		case 5: tic_api_ellib(tic, x, y, w / 2, h / 2, color); break;
+		case 6: tic_api_tri(tic, x, y, x + w, y + h / 3, x + w / 4, y + h, color); break;
+		case 7: tic_api_line(tic, x, y, x + w, y + h, color); break;
+		case 8: tic_api_spr(tic, color, x, y, 2, 2, trans, COUNT_OF(trans), 1 + w % 3, w % 4, h % 4); break;
+		case 9: tic_api_map(tic, x / 8, y / 8, w / 4, h / 4, x, y, trans, COUNT_OF(trans), 1, NULL, NULL); break;
+		case 10: tic_api_print(tic, "threads", x, y, color, w & 1, 1 + h % 2, false); break;
+		case 11:
+			tic_api_ttri(tic, x, y, x + w, y, x, y + h, 0, 0, 64, 0, 0, 64,
+				w % 2 ? tic_tiles_texture : tic_map_texture, trans, COUNT_OF(trans), 1 + w, 2 + h, 3, true);
+			break;
+		}
+	}
+}
+
+static void tickFrame(tic_mem* tic, s32 frame, u32* seed)
+{
+	tic_core_tick_start(tic);
+
+	if(frame % 16 == 0)
+		tic_api_clip(tic, rnd(seed) % 40 - 10, rnd(seed) % 30 - 10, 120 + rnd(seed) % 140, 60 + rnd(seed) % 100);
+
+	tic_api_cls(tic, frame);
+	drawFrame(tic, seed);
+
+	if(frame % 7 == 0)
+		tic_api_sfx(tic, rnd(seed) % SFX_COUNT, rnd(seed) % 96, rnd(seed) % 32, -1, rnd(seed) % TIC_SOUND_CHANNELS, MAX_VOLUME, MAX_VOLUME, 0);
+
+	tic_core_tick_end(tic);
+	tic_core_blit(tic);
+	tic_core_synth_sound(tic);
+}
+
+static void runJob(Job* job)
+{
+	tic_mem* tic = tic_core_create(44100, TIC80_PIXEL_COLOR_RGBA8888, TIC80_LATENCY_DEFAULT);
+
+	// random tiles, map and sfx, the same for every core
+	u32 seed = SEED;
+	for(u8 *ptr = (u8*)&tic->ram->tiles, *end = (u8*)&tic->ram->map + sizeof(tic_map); ptr < end; ptr++)
+		*ptr = rnd(&seed);
+
+	for(u8 *ptr = (u8*)&tic->ram->sfx, *end = ptr + sizeof(tic_sfx); ptr < end; ptr++)
+		*ptr = rnd(&seed);
+
+	job->video = job->audio = 2166136261u;
+
+	for(s32 i = 0; i < job->frames; i++)
+	{
+		tickFrame(tic, i, &seed);
+
+		job->video = hash(job->video, tic->product.screen, TIC80_FULLWIDTH * TIC80_FULLHEIGHT * sizeof(u32));
+		job->audio = hash(job->audio, tic->product.samples.buffer, tic->product.samples.count * sizeof(s16));
+	}
+
+	tic_core_close(tic);
+}
+
+#if defined(_WIN32)
+
+static DWORD WINAPI jobThread(LPVOID data)
+{
+	runJob(data);
+	return 0;
+}
+
+static bool runThreads(Job* jobs, s32 count)
+{
+	HANDLE* threads = malloc(sizeof(HANDLE) * count);
+	bool done = true;
+
+	for(s32 i = 0; i < count; i++)
+		threads[i] = CreateThread(NULL, 0, jobThread, &jobs[i], 0, NULL);
+
+	for(s32 i = 0; i < count; i++)
+		if(threads[i])
+		{
+			WaitForSingleObject(threads[i], INFINITE);
+			CloseHandle(threads[i]);
+		}
+		else done = false;
+
+	free(threads);
+
+	return done;
+}
+
+#else
+
+static void* jobThread(void* data)
+{
+	runJob(data);
+	return NULL;
+}
+
+static bool runThreads(Job* jobs, s32 count)
+{
+	pthread_t* threads = malloc(sizeof(pthread_t) * count);
+	bool* started = calloc(count, sizeof(bool));
+	bool done = true;
+
+	for(s32 i = 0; i < count; i++)
+		started[i] = pthread_create(&threads[i], NULL, jobThread, &jobs[i]) == 0;
+
+	for(s32 i = 0; i < count; i++)
+		if(started[i])
+			pthread_join(threads[i], NULL);
+		else done = false;
+
+	free(started);
+	free(threads);
+
+	return done;
+}
+
+#endif
+
+int main(int argc, char** argv)
+{
+	s32 threads = 8;
+	s32 frames = 300;
+
+	for(s32 i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+			threads = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+			frames = atoi(argv[++i]);
+		else frames = 0;
+	}
+
+	if(threads <= 0 || frames <= 0)
+	{
+		printf("usage: threadtest [-threads <n>] [-frames <n>]\n");
+		return -1;
+	}
+
+	Job single = {.frames = frames};
+	runJob(&single);
+
+	Job* jobs = calloc(threads, sizeof(Job));
+
+	for(s32 i = 0; i < threads; i++)
+		jobs[i].frames = frames;
+
+	if(!runThreads(jobs, threads))
+	{
+		printf("cannot start %d threads\n", threads);
+		free(jobs);
+		return -1;
+	}
+
+	s32 failed = 0;
+
+	printf("%-8s %8s %8s %s\n", "thread", "video", "audio", "result");
+	printf("%-8s %08x %08x\n", "single", single.video, single.audio);
+
+	for(s32 i = 0; i < threads; i++)
+	{
+		const Job* job = &jobs[i];
+		bool ok = job->video == single.video && job->audio == single.audio;
+
+		if(!ok)
+			failed++;
+
+		printf("%-8d %08x %08x %s\n", i, job->video, job->audio, ok ? "ok" : "FAIL differs from single thread");
+	}
+
+	printf("%d threads, %d frames each, %d failed\n", threads, frames, failed);
+
+	free(jobs);
+
+	return failed ? 1 : 0;
+}
@@ -55,6 +55,26 @@ typedef enum {
     TIC80_PIXEL_COLOR_BGRA8888 = (4 << 8) | 32
 } tic80_pixel_color_format;
 
+// low latency keeps fewer frames of sound registers and samples queued,
+// it suits hosts whose frames and audio device run in lockstep
+typedef enum
+{
+    TIC80_LATENCY_DEFAULT,
+    TIC80_LATENCY_LOW,
+} tic80_latency;
+
+typedef struct
+{
+    // frames the latest sound registers wait until they are synthesized
+    s32 delay;
+
+    // synths that found no new registers and repeated the last ones
+    u32 underruns;
+
+    // ticks whose registers were dropped because the ring was full
+    u32 overruns;
+} tic80_sound_stats;
+
 typedef struct 
 {
     struct
@@ -174,12 +194,31 @@ typedef struct
 
 } tic80_input;
 
+// every tic80 instance owns all of its mutable state, so separate instances
+// can be created, loaded, ticked and deleted on separate threads at the same
+// time; a single instance must not be used from two threads at once.
+// Janet, mruby and Wren carts keep their VM state in globals and are
+// the exception, only one instance running them may be ticked at a time
 TIC80_API tic80* tic80_create(s32 samplerate, tic80_pixel_color_format format);
+TIC80_API tic80* tic80_create_ex(s32 samplerate, tic80_pixel_color_format format, tic80_latency latency);
 TIC80_API void tic80_load(tic80* tic, void* cart, s32 size);
 TIC80_API void tic80_tick(tic80* tic, tic80_input input, u64 (*counter)(), u64 (*freq)());
 TIC80_API void tic80_sound(tic80* tic);
+TIC80_API tic80_sound_stats tic80_sound_stats_get(tic80* tic);
+
+// with the buses on, tic80_sound also leaves every channel alone in its
+// own buffer laid out like tic80::samples, the mix itself doesn't change.
+// Buses turned on mid-play settle to the mix within half a second;
+// tic80_sound_bus returns NULL while they are off
+TIC80_API void tic80_sound_buses(tic80* tic, bool enable);
+TIC80_API const TIC80_SAMPLETYPE* tic80_sound_bus(tic80* tic, s32 channel);
 TIC80_API void tic80_delete(tic80* tic);
 
+// keep up to 'budget' bytes of per frame history (0 turns it off),
+// tic80_rewind steps one frame back instead of ticking
+TIC80_API void tic80_rewind_init(tic80* tic, s32 budget);
+TIC80_API bool tic80_rewind(tic80* tic);
+
 #ifdef __cplusplus
 }
 #endif
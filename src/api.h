@@ -25,6 +25,7 @@
 #include "retro_endianness.h"
 #include "tic.h"
 #include "time.h"
+#include "ext/tracing.h"
 
 // convenience macros to loop languages
 #define FOR_EACH_LANG(ln) for (tic_script_config** conf = Languages ; *conf != NULL; conf++ ) { tic_script_config* ln = *conf;
@@ -39,6 +40,8 @@ typedef void(*ErrorOutput)(void*, const char*);
 typedef void(*ExitCallback)(void*);
 typedef u64(*CounterCallback)(void*);
 typedef u64(*FreqCallback)(void*);
+typedef void*(*CacheLoadCallback)(void*, const char* kind, const char* key, s32* size);
+typedef void(*CacheSaveCallback)(void*, const char* kind, const char* key, const void* buffer, s32 size);
 
 typedef struct
 {
@@ -50,6 +53,14 @@ typedef struct
     FreqCallback freq;
     u64 start;
 
+    // optional, keeps the script cache across runs, the loaded buffer is freed by the core
+    CacheLoadCallback cacheLoad;
+    CacheSaveCallback cacheSave;
+
+    // optional, the script time in ms a frame can take, the running code is
+    // stopped with an error when it's over, 0 is no limit
+    u32 budget;
+
     void* data;
 } tic_tick_data;
 
@@ -86,6 +97,9 @@ typedef struct
         bool(*init)(tic_mem* memory, const char* code);
         void(*close)(tic_mem* memory);
 
+        // frees the VM a language may keep in spareVM for the next init
+        void(*release)(tic_mem* memory);
+
         tic_tick tick;
         tic_boot boot;
         tic_blit_callback callback;
@@ -94,6 +108,14 @@ typedef struct
     const tic_outline_item* (*getOutline)(const char* code, s32* size);
     void (*eval)(tic_mem* tic, const char* code);
 
+    // optional VM snapshot for savestates, NULL when the language can't do it
+    struct
+    {
+        s32(*size)(tic_mem* memory);
+        void(*save)(tic_mem* memory, void* buffer);
+        void(*load)(tic_mem* memory, const void* buffer);
+    } state;
+
     const char* blockCommentStart;
     const char* blockCommentEnd;
     const char* blockCommentStart2;
@@ -594,6 +616,18 @@ enum
         tic_mem*)                                                                                                       \
                                                                                                                         \
                                                                                                                         \
+    macro(cpu,                                                                                                          \
+        "cpu() -> ms",                                                                                                  \
+                                                                                                                        \
+        "This function returns the milliseconds the cart code has taken in the current frame so far.\n"                 \
+        "Useful for keeping heavy frames under control or spreading the work over several frames.",                     \
+        0,                                                                                                              \
+        0,                                                                                                              \
+        0,                                                                                                              \
+        double,                                                                                                         \
+        tic_mem*)                                                                                                       \
+                                                                                                                        \
+                                                                                                                        \
     macro(exit,                                                                                                         \
         "exit()",                                                                                                       \
                                                                                                                         \
@@ -835,6 +869,74 @@ enum
 TIC_API_LIST(TIC_API_DEF)
 #undef TIC_API_DEF
 
+enum
+{
+#define TIC_API_INDEX(name, ...) tic_api_##name##_index,
+    TIC_API_LIST(TIC_API_INDEX)
+#undef TIC_API_INDEX
+    TIC_API_COUNT
+};
+
+#define TIC_PROFILE_STAGE_LIST(macro)   \
+    macro(start,    "tick_start")       \
+    macro(tic,      TIC_FN)             \
+    macro(scn,      SCN_FN)             \
+    macro(bdr,      BDR_FN)             \
+    macro(blit,     "blit")             \
+    macro(synth,    "synth")
+
+typedef enum
+{
+#define TIC_PROFILE_STAGE_DEF(name, _) tic_profile_##name,
+    TIC_PROFILE_STAGE_LIST(TIC_PROFILE_STAGE_DEF)
+#undef  TIC_PROFILE_STAGE_DEF
+    TIC_PROFILE_STAGES
+} tic_profile_stage;
+
+typedef struct
+{
+    u32 calls;
+    u64 time;
+} tic_profile_item;
+
+typedef struct
+{
+    tic_profile_item api[TIC_API_COUNT];
+    tic_profile_item stage[TIC_PROFILE_STAGES];
+} tic_profile_frame;
+
+// times are in tic_tick_data counter units, 'last' is the previous complete
+// frame and 'total' sums every frame since profiling was turned on
+typedef struct
+{
+    u64 freq;
+    u32 frames;
+    tic_profile_frame last;
+    tic_profile_frame total;
+} tic_profile_data;
+
+// printable names indexed by tic_profile_stage and by tic_api_*_index
+extern const char* const ProfileStageNames[TIC_PROFILE_STAGES];
+extern const char* const ApiNames[TIC_API_COUNT];
+
+// the last script start: compiling or loading the code and running its body,
+// 'cached' is set when it came from the script cache
+typedef struct
+{
+    u64 freq;
+    u64 time;
+    bool cached;
+} tic_script_init;
+
+// the block synth walks each channel once per frame for both sides and only
+// emits the steps that change the amplitude, the step synth is the original
+// per step renderer kept for comparison, both produce the same samples
+typedef enum
+{
+    tic_synth_block,
+    tic_synth_step,
+} tic_synth;
+
 struct tic_mem
 {
     tic80           product;
@@ -866,17 +968,34 @@ struct tic_mem
     } input;
 };
 
-tic_mem* tic_core_create(s32 samplerate, tic80_pixel_color_format format);
+tic_mem* tic_core_create(s32 samplerate, tic80_pixel_color_format format, tic80_latency latency);
 void tic_core_close(tic_mem* memory);
 void tic_core_pause(tic_mem* memory);
 void tic_core_resume(tic_mem* memory);
+s32 tic_core_state_size(tic_mem* memory);
+bool tic_core_state_vm(tic_mem* memory);
+bool tic_core_state_save(tic_mem* memory, void* buffer, s32 size);
+bool tic_core_state_load(tic_mem* memory, const void* buffer, s32 size);
+void tic_core_rewind_init(tic_mem* memory, u32 budget);
+void tic_core_rewind_push(tic_mem* memory);
+bool tic_core_rewind_back(tic_mem* memory);
 void tic_core_tick_start(tic_mem* memory);
 void tic_core_tick(tic_mem* memory, tic_tick_data* data);
 void tic_core_tick_end(tic_mem* memory);
+void tic_core_sound_tick_start(tic_mem* memory);
+void tic_core_sound_tick_end(tic_mem* memory);
 void tic_core_synth_sound(tic_mem* tic);
+void tic_core_synth(tic_mem* memory, tic_synth synth);
+void tic_core_sound_buses(tic_mem* memory, bool enable);
+const s16* tic_core_sound_bus(tic_mem* memory, s32 channel);
+const tic80_sound_stats* tic_core_sound_stats(tic_mem* memory);
 void tic_core_blit(tic_mem* tic);
 void tic_core_blit_ex(tic_mem* tic, tic_blit_callback clb);
 const tic_script_config* tic_core_script_config(tic_mem* memory);
+void tic_core_profile(tic_mem* memory, bool enable);
+const tic_profile_data* tic_core_profile_data(tic_mem* memory);
+const tic_script_init* tic_core_script_init(tic_mem* memory);
+void tic_core_tracing(tic_mem* memory, Tracing* tracing);
 
 #define VBANK(tic, bank)                                \
     bool MACROVAR(_bank_) = tic_api_vbank(tic, bank);   \
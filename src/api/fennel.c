@@ -44,6 +44,29 @@ static const char* execute_fennel_src = FENNEL_CODE(
   if(not ok) then return msg end
 );
 
+// the same options fennel.eval would use, strict mode allows the current globals only
+static const char* compile_fennel_src = FENNEL_CODE(
+  local fennel = require("fennel")
+  debug.traceback = fennel.traceback
+  local src = ...
+  local opts = {allowedGlobals = false, ["error-pinpoint"]={">>", "<<"}, source = src}
+  if(src:find("\n;; +strict: *true")) then
+    opts.allowedGlobals = {}
+    for name in pairs(_G) do table.insert(opts.allowedGlobals, fennel.unmangle(name)) end
+  end
+  return fennel.compileString(src, opts)
+);
+
+// the cart env, fennel.traceback loads the compiler on the first call
+static const char* env_fennel_src = FENNEL_CODE(
+  io = { read = true }
+  debug.traceback = function(...)
+    local fennel = require("fennel")
+    debug.traceback = fennel.traceback
+    return fennel.traceback(...)
+  end
+);
+
 static bool initFennel(tic_mem* tic, const char* code)
 {
     tic_core* core = (tic_core*)tic;
@@ -51,6 +74,7 @@ static bool initFennel(tic_mem* tic, const char* code)
 
     lua_State* lua = core->currentVM = luaL_newstate();
     lua_open_builtins(lua);
+    lua_lazy_compiler(lua, loadfennel_lua, loadfennel_lua_len, "fennel.lua");
 
     initLuaAPI(core);
 
@@ -59,28 +83,46 @@ static bool initFennel(tic_mem* tic, const char* code)
 
         lua_settop(fennel, 0);
 
-        if (luaL_loadbuffer(fennel, (const char *)loadfennel_lua,
-                            loadfennel_lua_len, "fennel.lua") != LUA_OK)
+        if (luaL_loadbuffer(fennel, env_fennel_src, strlen(env_fennel_src), "fennel_env") != LUA_OK
+            || lua_pcall(fennel, 0, 0, 0) != LUA_OK)
         {
-            core->data->error(core->data->data, "failed to load fennel compiler");
+            core->data->error(core->data->data, lua_tostring(fennel, -1));
             return false;
         }
 
-        lua_call(fennel, 0, 0);
+        s32 codeSize = (s32)strlen(code), size = 0;
+        const char* compiled = tic_core_cache_load(core, "fennel", code, codeSize, &size);
 
-        if (luaL_loadbuffer(fennel, execute_fennel_src, strlen(execute_fennel_src), "execute_fennel") != LUA_OK)
+        if (!compiled)
         {
-            core->data->error(core->data->data, "failed to load fennel compiler");
-            return false;
+            if (luaL_loadbuffer(fennel, compile_fennel_src, strlen(compile_fennel_src), "compile_fennel") != LUA_OK)
+            {
+                core->data->error(core->data->data, "failed to load fennel compiler");
+                return false;
+            }
+
+            lua_pushstring(fennel, code);
+
+            if (lua_pcall(fennel, 1, 1, 0) != LUA_OK)
+            {
+                core->data->error(core->data->data, lua_tostring(fennel, -1));
+                return false;
+            }
+
+            size_t len = 0;
+            compiled = lua_tolstring(fennel, -1, &len);
+            size = (s32)len;
+
+            tic_core_cache_save(core, "fennel", code, codeSize, compiled, size);
         }
 
-        lua_pushstring(fennel, code);
-        lua_call(fennel, 1, 1);
-        const char* err = lua_tostring(fennel, -1);
+        tic_core_budget_arm(core);
 
-        if (err)
+        // fennel.eval names the chunk after the source
+        if (luaL_loadbuffer(fennel, compiled, size, code) != LUA_OK
+            || lua_pcall(fennel, 0, 0, 0) != LUA_OK)
         {
-            core->data->error(core->data->data, err);
+            core->data->error(core->data->data, lua_tostring(fennel, -1));
             return false;
         }
     }
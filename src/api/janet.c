@@ -25,6 +25,7 @@
 // SOFTWARE.
 
 #include "core/core.h"
+#include "core/profile.h"
 
 #if defined(TIC_BUILD_WITH_JANET)
 
@@ -59,6 +60,7 @@ static Janet janet_trace(int32_t argc, Janet* argv);
 static Janet janet_pmem(int32_t argc, Janet* argv);
 static Janet janet_time(int32_t argc, Janet* argv);
 static Janet janet_tstamp(int32_t argc, Janet* argv);
+static Janet janet_cpu(int32_t argc, Janet* argv);
 static Janet janet_exit(int32_t argc, Janet* argv);
 static Janet janet_font(int32_t argc, Janet* argv);
 static Janet janet_mouse(int32_t argc, Janet* argv);
@@ -121,6 +123,7 @@ static const JanetReg janet_c_functions[] =
     {"pmem", janet_pmem, NULL},
     {"time", janet_time, NULL},
     {"tstamp", janet_tstamp, NULL},
+    {"cpu", janet_cpu, NULL},
     {"exit", janet_exit, NULL},
     {"font", janet_font, NULL},
     {"mouse", janet_mouse, NULL},
@@ -164,8 +167,13 @@ static JanetBuffer *errBuffer;
 static tic_core* CurrentMachine = NULL;
 
 
+// every API call gets the core here, Janet can't be interrupted from
+// the same thread, so a frame over its budget is stopped at the next call
 static inline tic_core* getJanetMachine(void)
 {
+    if (tic_core_budget_over(CurrentMachine))
+        janet_panic(tic_core_budget_report(CurrentMachine));
+
     return CurrentMachine;
 }
 
@@ -717,6 +725,13 @@ static Janet janet_tstamp(int32_t argc, Janet* argv)
     return janet_wrap_integer(tic_api_tstamp(memory));
 }
 
+static Janet janet_cpu(int32_t argc, Janet* argv)
+{
+    janet_fixarity(argc, 0);
+    tic_mem* memory = (tic_mem*)getJanetMachine();
+    return janet_wrap_number(tic_api_cpu(memory));
+}
+
 static Janet janet_exit(int32_t argc, Janet* argv)
 {
     janet_fixarity(argc, 0);
@@ -1084,6 +1099,7 @@ static bool initJanet(tic_mem* tic, const char* code)
     Janet result;
 
     // Load the game source code
+    tic_core_budget_arm(core);
     if (janet_dostring(core->currentVM, code, "main", &result)) {
         reportError(core, result);
         return false;
@@ -21,12 +21,14 @@
 // SOFTWARE.
 
 #include "core/core.h"
+#include "core/profile.h"
 
 #if defined(TIC_BUILD_WITH_JS)
 
 #include "tools.h"
 
 #include <ctype.h>
+#include <stdlib.h>
 #include <string.h>
 #include <quickjs.h>
 
@@ -110,6 +112,90 @@ static void js_std_dump_error(JSContext *ctx)
     JS_FreeValue(ctx, exception_val);
 }
 
+// the callbacks are looked up by atom once a frame instead of on every call,
+// QuickJS can't tell us when a global function gets reassigned
+#define JS_CALLBACK_LIST(macro)     \
+    macro(tic,      TIC_FN)         \
+    macro(scn,      SCN_FN)         \
+    macro(scanline, "scanline")     \
+    macro(bdr,      BDR_FN)         \
+    macro(boot,     BOOT_FN)        \
+    macro(menu,     MENU_FN)
+
+typedef enum
+{
+#define JS_CALLBACK_DEF(name, _) JsCallback_##name,
+    JS_CALLBACK_LIST(JS_CALLBACK_DEF)
+#undef  JS_CALLBACK_DEF
+    JsCallbacksCount
+} JsCallback;
+
+typedef struct
+{
+    JSValue global;
+    JSAtom names[JsCallbacksCount];
+    JSValue funcs[JsCallbacksCount];
+} JsVM;
+
+static inline JsVM* getVM(JSContext *ctx)
+{
+    return JS_GetRuntimeOpaque(JS_GetRuntime(ctx));
+}
+
+static void initCallbacks(JSContext *ctx)
+{
+    JsVM* vm = calloc(1, sizeof(JsVM));
+    vm->global = JS_GetGlobalObject(ctx);
+
+    static const char* const Names[] =
+    {
+#define JS_CALLBACK_DEF(_, name) name,
+        JS_CALLBACK_LIST(JS_CALLBACK_DEF)
+#undef  JS_CALLBACK_DEF
+    };
+
+    for(s32 i = 0; i < JsCallbacksCount; i++)
+    {
+        vm->names[i] = JS_NewAtom(ctx, Names[i]);
+        vm->funcs[i] = JS_UNDEFINED;
+    }
+
+    JS_SetRuntimeOpaque(JS_GetRuntime(ctx), vm);
+}
+
+static void freeCallbacks(JSContext *ctx)
+{
+    JsVM* vm = getVM(ctx);
+
+    for(s32 i = 0; i < JsCallbacksCount; i++)
+    {
+        JS_FreeValue(ctx, vm->funcs[i]);
+        JS_FreeAtom(ctx, vm->names[i]);
+    }
+
+    JS_FreeValue(ctx, vm->global);
+    JS_SetRuntimeOpaque(JS_GetRuntime(ctx), NULL);
+    free(vm);
+}
+
+static JSValue resolveCallback(JSContext *ctx, JsCallback index)
+{
+    JsVM* vm = getVM(ctx);
+
+    JS_FreeValue(ctx, vm->funcs[index]);
+    vm->funcs[index] = JS_GetProperty(ctx, vm->global, vm->names[index]);
+
+    return vm->funcs[index];
+}
+
+// the scanlines and the border of a frame come after TIC
+static void resolveScanlineCallbacks(JSContext *ctx)
+{
+    resolveCallback(ctx, JsCallback_scn);
+    resolveCallback(ctx, JsCallback_scanline);
+    resolveCallback(ctx, JsCallback_bdr);
+}
+
 static void closeJavascript(tic_mem* tic)
 {
     tic_core* core = (tic_core*)tic;
@@ -118,6 +204,7 @@ static void closeJavascript(tic_mem* tic)
     if(ctx)
     {
         JSRuntime *rt = JS_GetRuntime(ctx);
+        freeCallbacks(ctx);
         JS_FreeContext(ctx);
         JS_FreeRuntime(rt);
         core->currentVM = NULL;
@@ -219,7 +306,7 @@ static JSValue js_rectb(JSContext *ctx, JSValueConst this_val, s32 argc, JSValue
 
 static JSValue js_spr(JSContext *ctx, JSValueConst this_val, s32 argc, JSValueConst *argv)
 {
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
 
     s32 index = getInteger2(ctx, argv[0], 0);
@@ -449,7 +536,7 @@ static JSValue js_map(JSContext *ctx, JSValueConst this_val, s32 argc, JSValueCo
     s32 sy = getInteger2(ctx, argv[5], 0);
     s32 scale = getInteger2(ctx, argv[7], 1);
 
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
 
     if(JS_IsArray(ctx, argv[6]))
@@ -660,6 +747,13 @@ static JSValue js_tstamp(JSContext *ctx, JSValueConst this_val, s32 argc, JSValu
     return JS_NewInt32(ctx, tic_api_tstamp(tic));
 }
 
+static JSValue js_cpu(JSContext *ctx, JSValueConst this_val, s32 argc, JSValueConst *argv)
+{
+    tic_mem* tic = (tic_mem*)getCore(ctx);
+
+    return JS_NewFloat64(ctx, tic_api_cpu(tic));
+}
+
 static JSValue js_exit(JSContext *ctx, JSValueConst this_val, s32 argc, JSValueConst *argv)
 {
     tic_api_exit((tic_mem*)getCore(ctx));
@@ -810,7 +904,7 @@ static JSValue js_textri(JSContext *ctx, JSValueConst this_val, s32 argc, JSValu
     tic_mem* tic = (tic_mem*)getCore(ctx);
     bool use_map = JS_ToBool(ctx, argv[12]);
 
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
     if(JS_IsArray(ctx, argv[13]))
     {
@@ -852,7 +946,7 @@ static JSValue js_ttri(JSContext *ctx, JSValueConst this_val, s32 argc, JSValueC
     tic_mem* tic = (tic_mem*)getCore(ctx);
     tic_texture_src src = getInteger(ctx, argv[12]);
 
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
     if(JS_IsArray(ctx, argv[13]))
     {
@@ -997,6 +1091,47 @@ static JSValue js_fset(JSContext *ctx, JSValueConst this_val, s32 argc, JSValueC
     return JS_UNDEFINED;
 }
 
+// the bytecode keeps the debug info, so the errors read the same as from the source
+static JSValue compileJavascript(tic_core* core, JSContext* ctx, const char* code)
+{
+    s32 size = (s32)strlen(code), bytecodeSize = 0;
+    const void* bytecode = tic_core_cache_load(core, "qjs", code, size, &bytecodeSize);
+
+    if(bytecode)
+    {
+        JSValue func = JS_ReadObject(ctx, bytecode, bytecodeSize, JS_READ_OBJ_BYTECODE);
+
+        if(!JS_IsException(func))
+            return func;
+
+        JS_FreeValue(ctx, JS_GetException(ctx));
+        core->init.cached = false;
+    }
+
+    JSValue func = JS_Eval(ctx, code, size, "index.js", JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
+
+    if(!JS_IsException(func))
+    {
+        size_t dumpSize = 0;
+        u8* dump = JS_WriteObject(ctx, &dumpSize, func, JS_WRITE_OBJ_BYTECODE);
+
+        if(dump)
+        {
+            tic_core_cache_save(core, "qjs", code, size, dump, (s32)dumpSize);
+            js_free(ctx, dump);
+        }
+        else JS_FreeValue(ctx, JS_GetException(ctx));
+    }
+
+    return func;
+}
+
+// QuickJS polls it every few thousand ops, the thrown error can't be caught by the cart
+static s32 jsBudgetInterrupt(JSRuntime* rt, void* opaque)
+{
+    return tic_core_budget_over(opaque);
+}
+
 static bool initJavascript(tic_mem* tic, const char* code)
 {
     closeJavascript(tic);
@@ -1007,6 +1142,10 @@ static bool initJavascript(tic_mem* tic, const char* code)
     tic_core* core = (tic_core*)tic;
     core->currentVM = ctx;
     JS_SetContextOpaque(ctx, core);
+    initCallbacks(ctx);
+
+    if(core->data->budget)
+        JS_SetInterruptHandler(rt, jsBudgetInterrupt, core);
 
     {
         JSValue global = JS_GetGlobalObject(ctx);
@@ -1025,7 +1164,12 @@ static bool initJavascript(tic_mem* tic, const char* code)
         JS_FreeValue(ctx, global);
     }
 
-    JSValue ret = JS_Eval(ctx, code, strlen(code), "index.js", JS_EVAL_TYPE_GLOBAL);
+    JSValue func = compileJavascript(core, ctx, code);
+
+    if(!JS_IsException(func))
+        tic_core_budget_arm(core);
+
+    JSValue ret = JS_IsException(func) ? func : JS_EvalFunction(ctx, func);
     if (JS_IsException(ret))
     {
         js_std_dump_error(ctx);
@@ -1072,8 +1216,8 @@ static void callJavascriptTick(tic_mem* tic)
 
     if(ctx)
     {
-        JSValue global = JS_GetGlobalObject(ctx);
-        JSValue func = JS_GetPropertyStr(ctx, global, TIC_FN);
+        JSValue global = getVM(ctx)->global;
+        JSValue func = resolveCallback(ctx, JsCallback_tic);
 
         if(JS_IsFunction(ctx, func))
         {
@@ -1116,44 +1260,42 @@ static void callJavascriptTick(tic_mem* tic)
         }
         else core->data->error(core->data->data, "'function TIC()...' isn't found :(");
 
-        JS_FreeValue(ctx, func);
-        JS_FreeValue(ctx, global);
+        resolveScanlineCallbacks(ctx);
     }
 }
 
-static void callJavascriptIntCallback(tic_mem* tic, s32 value, void* data, const char* name)
+static void callJavascriptIntCallback(tic_mem* tic, s32 value, JSValue func)
 {
     tic_core* core = (tic_core*)tic;
     JSContext* ctx = core->currentVM;
 
-    JSValue global = JS_GetGlobalObject(ctx);
-    JSValue func = JS_GetPropertyStr(ctx, global, name);
-
     if(JS_IsFunction(ctx, func))
     {
-        callFunc1(ctx, func, global, JS_NewInt32(ctx, value));
+        callFunc1(ctx, func, getVM(ctx)->global, JS_NewInt32(ctx, value));
     }
-
-    JS_FreeValue(ctx, func);
-    JS_FreeValue(ctx, global);
 }
 
 static void callJavascriptScanline(tic_mem* tic, s32 row, void* data)
 {
-    callJavascriptIntCallback(tic, row, data, SCN_FN);
+    tic_core* core = (tic_core*)tic;
+    JsVM* vm = getVM(core->currentVM);
+
+    callJavascriptIntCallback(tic, row, vm->funcs[JsCallback_scn]);
 
     // try to call old scanline
-    callJavascriptIntCallback(tic, row, data, "scanline");
+    callJavascriptIntCallback(tic, row, vm->funcs[JsCallback_scanline]);
 }
 
 static void callJavascriptBorder(tic_mem* tic, s32 row, void* data)
 {
-    callJavascriptIntCallback(tic, row, data, BDR_FN);
+    tic_core* core = (tic_core*)tic;
+    callJavascriptIntCallback(tic, row, getVM(core->currentVM)->funcs[JsCallback_bdr]);
 }
 
 static void callJavascriptMenu(tic_mem* tic, s32 index, void* data)
 {
-    callJavascriptIntCallback(tic, index, data, MENU_FN);
+    tic_core* core = (tic_core*)tic;
+    callJavascriptIntCallback(tic, index, resolveCallback(core->currentVM, JsCallback_menu));
 }
 
 static void callJavascriptBoot(tic_mem* tic)
@@ -1161,16 +1303,14 @@ static void callJavascriptBoot(tic_mem* tic)
     tic_core* core = (tic_core*)tic;
     JSContext* ctx = core->currentVM;
 
-    JSValue global = JS_GetGlobalObject(ctx);
-    JSValue func = JS_GetPropertyStr(ctx, global, BOOT_FN);
+    JSValue func = resolveCallback(ctx, JsCallback_boot);
 
     if(JS_IsFunction(ctx, func))
     {
-        callFunc(ctx, func, global);
+        callFunc(ctx, func, getVM(ctx)->global);
     }
 
-    JS_FreeValue(ctx, func);
-    JS_FreeValue(ctx, global);
+    resolveScanlineCallbacks(ctx);
 }
 
 static const char* const JsKeywords [] =
@@ -21,6 +21,7 @@
 // SOFTWARE.
 
 #include "core/core.h"
+#include "core/profile.h"
 
 #if defined(TIC_BUILD_WITH_LUA)
 
@@ -434,7 +435,7 @@ static s32 lua_textri(lua_State* lua)
             pt[i] = (float)lua_tonumber(lua, i + 1);
 
         tic_mem* tic = (tic_mem*)getLuaCore(lua);
-        static u8 colors[TIC_PALETTE_SIZE];
+        u8 colors[TIC_PALETTE_SIZE];
         s32 count = 0;
         bool use_map = false;
 
@@ -498,7 +499,7 @@ static s32 lua_ttri(lua_State* lua)
             pt[i] = (float)lua_tonumber(lua, i + 1);
 
         tic_mem* tic = (tic_mem*)getLuaCore(lua);
-        static u8 colors[TIC_PALETTE_SIZE];
+        u8 colors[TIC_PALETTE_SIZE];
         s32 count = 0;
         tic_texture_src src = tic_tiles_texture;
 
@@ -660,7 +661,7 @@ static s32 lua_spr(lua_State* lua)
     s32 scale = 1;
     tic_flip flip = tic_no_flip;
     tic_rotate rotate = tic_no_rotate;
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
 
     if(top >= 1) 
@@ -799,7 +800,7 @@ static s32 lua_map(lua_State* lua)
     s32 sx = 0;
     s32 sy = 0;
     s32 scale = 1;
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
 
     s32 top = lua_gettop(lua);
@@ -1405,6 +1406,15 @@ static s32 lua_tstamp(lua_State *lua)
     return 1;
 }
 
+static s32 lua_cpu(lua_State *lua)
+{
+    tic_mem* tic = (tic_mem*)getLuaCore(lua);
+
+    lua_pushnumber(lua, tic_api_cpu(tic));
+
+    return 1;
+}
+
 static s32 lua_exit(lua_State *lua)
 {
     tic_api_exit((tic_mem*)getLuaCore(lua));
@@ -1518,6 +1528,85 @@ void lua_open_builtins(lua_State *lua)
     }
 }
 
+static s32 lua_loaded_module(lua_State *lua)
+{
+    lua_pushvalue(lua, lua_upvalueindex(1));
+    return 1;
+}
+
+// runs the compiler chunk the first time a module isn't preloaded
+static s32 lua_compiler_searcher(lua_State *lua)
+{
+    const char* name = luaL_checkstring(lua, 1);
+
+    if(!lua_toboolean(lua, lua_upvalueindex(4)))
+    {
+        lua_pushboolean(lua, true);
+        lua_replace(lua, lua_upvalueindex(4));
+
+        if(luaL_loadbuffer(lua, lua_touserdata(lua, lua_upvalueindex(1)), 
+            lua_tointeger(lua, lua_upvalueindex(2)), lua_tostring(lua, lua_upvalueindex(3))) != LUA_OK)
+            return lua_error(lua);
+
+        lua_call(lua, 0, 0);
+    }
+
+    lua_getglobal(lua, LUA_LOADLIBNAME);
+
+    lua_getfield(lua, -1, "preload");
+    lua_getfield(lua, -1, name);
+
+    if(lua_isfunction(lua, -1))
+        return 1;
+
+    // the compiler can also put itself right into package.loaded
+    lua_getfield(lua, -3, "loaded");
+    lua_getfield(lua, -1, name);
+
+    if(!lua_isnil(lua, -1))
+    {
+        lua_pushcclosure(lua, lua_loaded_module, 1);
+        return 1;
+    }
+
+    lua_pushfstring(lua, "\n\tno module '%s' in %s", name, lua_tostring(lua, lua_upvalueindex(3)));
+    return 1;
+}
+
+// the compiler is parsed and run only when the code requires one of its modules
+void lua_lazy_compiler(lua_State *lua, const void* chunk, s32 size, const char* name)
+{
+    lua_getglobal(lua, LUA_LOADLIBNAME);
+    lua_getfield(lua, -1, "searchers");
+
+    // right after the preload searcher
+    for(s32 i = (s32)lua_rawlen(lua, -1); i >= 2; i--)
+    {
+        lua_rawgeti(lua, -1, i);
+        lua_rawseti(lua, -2, i + 1);
+    }
+
+    lua_pushlightuserdata(lua, (void*)chunk);
+    lua_pushinteger(lua, size);
+    lua_pushstring(lua, name);
+    lua_pushboolean(lua, false);
+    lua_pushcclosure(lua, lua_compiler_searcher, 4);
+    lua_rawseti(lua, -2, 2);
+
+    lua_pop(lua, 2);
+}
+
+// instructions between the budget checks
+#define LUA_BUDGET_COUNT 1000
+
+static void luaBudgetHook(lua_State* lua, lua_Debug* ar)
+{
+    tic_core* core = *(tic_core**)lua_getextraspace(lua);
+
+    if(tic_core_budget_over(core))
+        luaL_error(lua, "%s", tic_core_budget_report(core));
+}
+
 void initLuaAPI(tic_core* core)
 {
     static const struct{lua_CFunction func; const char* name;} ApiItems[] = 
@@ -1536,6 +1625,14 @@ void initLuaAPI(tic_core* core)
 
     registerLuaFunction(core, lua_dofile, "dofile");
     registerLuaFunction(core, lua_loadfile, "loadfile");
+
+    // a count hook slows every instruction down, so it's only set with a budget,
+    // the coroutines get the hook and the core pointer from the main thread
+    if(core->data->budget)
+    {
+        *(tic_core**)lua_getextraspace(core->currentVM) = core;
+        lua_sethook(core->currentVM, luaBudgetHook, LUA_MASKCOUNT, LUA_BUDGET_COUNT);
+    }
 }
 
 void closeLua(tic_mem* tic)
@@ -1549,6 +1646,63 @@ void closeLua(tic_mem* tic)
     }
 }
 
+typedef struct
+{
+    u8* data;
+    s32 size;
+    s32 capacity;
+} LuaDump;
+
+static s32 writeLuaDump(lua_State* lua, const void* data, size_t size, void* ud)
+{
+    LuaDump* dump = ud;
+
+    if(dump->size + (s32)size > dump->capacity)
+    {
+        s32 capacity = MAX(dump->capacity * 2, dump->size + (s32)size);
+        u8* buffer = realloc(dump->data, capacity);
+
+        if(!buffer)
+            return 1;
+
+        dump->data = buffer;
+        dump->capacity = capacity;
+    }
+
+    memcpy(dump->data + dump->size, data, size);
+    dump->size += (s32)size;
+
+    return 0;
+}
+
+// the source stays the chunk name, so the errors read the same from the bytecode
+static bool loadLuaCode(tic_core* core, lua_State* lua, const char* code)
+{
+    s32 size = (s32)strlen(code), bytecodeSize = 0;
+    const void* bytecode = tic_core_cache_load(core, "luac", code, size, &bytecodeSize);
+
+    if(bytecode)
+    {
+        if(luaL_loadbufferx(lua, bytecode, bytecodeSize, "=bytecode", "b") == LUA_OK)
+            return true;
+
+        lua_pop(lua, 1);
+        core->init.cached = false;
+    }
+
+    if(luaL_loadstring(lua, code) != LUA_OK)
+        return false;
+
+    LuaDump dump = {0};
+
+    if(lua_dump(lua, writeLuaDump, &dump, 0) == 0)
+        tic_core_cache_save(core, "luac", code, size, dump.data, dump.size);
+
+    free(dump.data);
+
+    return true;
+}
+
 static bool initLua(tic_mem* tic, const char* code)
 {
     tic_core* core = (tic_core*)tic;
@@ -1565,7 +1719,15 @@ static bool initLua(tic_mem* tic, const char* code)
 
         lua_settop(lua, 0);
 
-        if(luaL_loadstring(lua, code) != LUA_OK || lua_pcall(lua, 0, LUA_MULTRET, 0) != LUA_OK)
+        if(!loadLuaCode(core, lua, code))
+        {
+            core->data->error(core->data->data, lua_tostring(lua, -1));
+            return false;
+        }
+
+        tic_core_budget_arm(core);
+
+        if(lua_pcall(lua, 0, LUA_MULTRET, 0) != LUA_OK)
         {
             core->data->error(core->data->data, lua_tostring(lua, -1));
             return false;
@@ -42,3 +42,4 @@ extern void callLuaMenu(tic_mem* tic, s32 index, void* data);
 extern void closeLua(tic_mem* tic);
 extern void callLuaTick(tic_mem* tic);
 extern void lua_open_builtins(lua_State *lua);
+extern void lua_lazy_compiler(lua_State *lua, const void* chunk, s32 size, const char* name);
@@ -46,6 +46,15 @@ static const char* execute_moonscript_src = MOON_CODE(
     return fn()
 );
 
+static const char* compile_moonscript_src = MOON_CODE(
+    local code, err = require('moonscript.base').to_lua(...)
+
+    if not code then
+        error(err)
+    end
+    return code
+);
+
 static void setloaded(lua_State* l, char* name)
 {
     s32 top = lua_gettop(l);
@@ -85,6 +94,7 @@ static bool initMoonscript(tic_mem* tic, const char* code)
 
     lua_State* lua = core->currentVM = luaL_newstate();
     lua_open_builtins(lua);
+    lua_lazy_compiler(lua, moonscript_lua, moonscript_lua_len, "moonscript.lua");
 
     luaopen_lpeg(lua);
     setloaded(lua, "lpeg");
@@ -96,25 +106,45 @@ static bool initMoonscript(tic_mem* tic, const char* code)
 
         lua_settop(moon, 0);
 
-        if (luaL_loadbuffer(moon, (const char *)moonscript_lua, moonscript_lua_len, "moonscript.lua") != LUA_OK)
+        if (luaL_loadbuffer(moon, execute_moonscript_src, strlen(execute_moonscript_src), "execute_moonscript") != LUA_OK)
         {
-            core->data->error(core->data->data, "failed to load moonscript.lua");
+            core->data->error(core->data->data, "failed to load moonscript compiler");
             return false;
         }
 
-        lua_call(moon, 0, 0);
+        lua_setglobal(lua, _ms_loadstring);
 
-        if (luaL_loadbuffer(moon, execute_moonscript_src, strlen(execute_moonscript_src), "execute_moonscript") != LUA_OK)
+        s32 codeSize = (s32)strlen(code), size = 0;
+        const char* compiled = tic_core_cache_load(core, "moon", code, codeSize, &size);
+
+        if (!compiled)
         {
-            core->data->error(core->data->data, "failed to load moonscript compiler");
-            return false;
+            if (luaL_loadbuffer(moon, compile_moonscript_src, strlen(compile_moonscript_src), "execute_moonscript") != LUA_OK)
+            {
+                core->data->error(core->data->data, "failed to load moonscript compiler");
+                return false;
+            }
+
+            lua_pushstring(moon, code);
+
+            if (lua_pcall(moon, 1, 1, 0) != LUA_OK)
+            {
+                core->data->error(core->data->data, lua_tostring(moon, -1));
+                return false;
+            }
+
+            size_t len = 0;
+            compiled = lua_tolstring(moon, -1, &len);
+            size = (s32)len;
+
+            tic_core_cache_save(core, "moon", code, codeSize, compiled, size);
         }
 
-        lua_setglobal(lua, _ms_loadstring);
-        lua_getglobal(lua, _ms_loadstring);
+        tic_core_budget_arm(core);
 
-        lua_pushstring(moon, code);
-        if (lua_pcall(moon, 1, 1, 0) != LUA_OK)
+        // the chunk name moonscript.loadstring gives
+        if (luaL_loadbuffer(moon, compiled, size, "=(moonscript.loadstring)") != LUA_OK
+            || lua_pcall(moon, 0, 0, 0) != LUA_OK)
         {
             const char* msg = lua_tostring(moon, -1);
 
@@ -22,6 +22,7 @@
 // SOFTWARE.
 
 #include "core/core.h"
+#include "core/profile.h"
 
 #if defined(TIC_BUILD_WITH_MRUBY)
 
@@ -45,8 +46,14 @@ typedef struct {
 } mrbVm;
 
 static tic_core* CurrentMachine = NULL;
+
+// mruby has no instruction hook in our build, so the budget is checked
+// when the cart calls the API and the error is raised from there
 static inline tic_core* getMRubyMachine(mrb_state* mrb)
 {
+    if (tic_core_budget_over(CurrentMachine))
+        mrb_raise(mrb, E_RUNTIME_ERROR, tic_core_budget_report(CurrentMachine));
+
     return CurrentMachine;
 }
 
@@ -418,7 +425,7 @@ static mrb_value mrb_spr(mrb_state* mrb, mrb_value self)
     mrb_int w = 1, h = 1, scale = 1;
     mrb_int flip = tic_no_flip, rotate = tic_no_rotate;
     mrb_value colors_obj;
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     mrb_int count = 0;
 
     mrb_int argc = mrb_get_args(mrb, "iii|oiiiii", &index, &x, &y, &colors_obj, &scale, &flip, &rotate, &w, &h);
@@ -943,6 +950,12 @@ static mrb_value mrb_time(mrb_state *mrb, mrb_value self)
     return mrb_float_value(mrb, tic_api_time(memory));
 }
 
+static mrb_value mrb_cpu(mrb_state *mrb, mrb_value self)
+{
+    tic_mem* memory = (tic_mem*)getMRubyMachine(mrb);
+    return mrb_float_value(mrb, tic_api_cpu(memory));
+}
+
 static mrb_value mrb_exit(mrb_state *mrb, mrb_value self)
 {
     tic_core* machine = getMRubyMachine(mrb);
@@ -1046,6 +1059,7 @@ static bool initMRuby(tic_mem* tic, const char* code)
         mrb_define_method(mrb, mrb->kernel_module, ApiItems[i].name, ApiItems[i].func, args);
     }
 
+    tic_core_budget_arm(machine);
     mrb_load_string_cxt(mrb, code, mrb_cxt);
     return catcherr(machine);
 }
@@ -1,4 +1,5 @@
 #include "core/core.h"
+#include "core/profile.h"
 
 #if defined(TIC_BUILD_WITH_PYTHON)
 
@@ -35,6 +36,14 @@ static bool get_core(pkpy_vm* vm, tic_core** core)
     if(!ok) return false;
     ok = pkpy_to_voidp(vm, -1, (void**) core);
     pkpy_pop_top(vm);
+
+    // pocketpy can't be interrupted, the API calls raise the budget error instead
+    if (ok && tic_core_budget_over(*core))
+    {
+        pkpy_error(vm, "tic80-panic!", pkpy_string(tic_core_budget_report(*core)));
+        return false;
+    }
+
     return ok;
 }
 
@@ -456,7 +465,7 @@ static int py_map(pkpy_vm* vm)
     int scale;
     bool used_remap;
 
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
 
     pkpy_to_int(vm, 0, &x);
     pkpy_to_int(vm, 1, &y);
@@ -957,7 +966,7 @@ static int py_spr(pkpy_vm* vm)
     int w;
     int h;
 
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
 
     pkpy_to_int(vm, 0, &spr_id);
     pkpy_to_int(vm, 1, &x);
@@ -1036,6 +1045,17 @@ static int py_tstamp(pkpy_vm* vm)
     return 1;
 }
 
+static int py_cpu(pkpy_vm* vm) 
+{
+    tic_mem* tic;
+    get_core(vm, (tic_core**) &tic);
+    if(pkpy_check_error(vm))
+        return 0;
+
+    pkpy_push_float(vm, tic_api_cpu(tic));
+    return 1;
+}
+
 static int py_tri(pkpy_vm* vm) 
 {
     tic_mem* tic;
@@ -1109,7 +1129,7 @@ static int py_ttri(pkpy_vm* vm)
     double z2;
     double z3;
 
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
 
     pkpy_to_float(vm, 0, &x1);
     pkpy_to_float(vm, 1, &y1);
@@ -1292,6 +1312,9 @@ static bool setup_c_bindings(pkpy_vm* vm) {
     pkpy_push_function(vm, "tstamp() -> int", py_tstamp);
     pkpy_setglobal_2(vm, "tstamp");
 
+    pkpy_push_function(vm, "cpu() -> float", py_cpu);
+    pkpy_setglobal_2(vm, "cpu");
+
     pkpy_push_function(vm, "vbank(bank: int=None) -> int", py_vbank);
     pkpy_setglobal_2(vm, "vbank");
 
@@ -1350,6 +1373,8 @@ static bool initPython(tic_mem* tic, const char* code)
         return false;
     }
 
+    tic_core_budget_arm(core);
+
     if(!pkpy_exec(vm, code)) 
     {
         report_error(core, "error while processing the main code\n");
@@ -21,6 +21,7 @@
 // SOFTWARE.
 
 #include "core/core.h"
+#include "core/profile.h"
 
 #if defined(TIC_BUILD_WITH_SCHEME)
 
@@ -150,7 +151,7 @@ s7_pointer scheme_spr(s7_scheme* sc, s7_pointer args)
     const s32 x         = s7_integer(s7_cadr(args));
     const s32 y         = s7_integer(s7_caddr(args));
 
-    static u8 trans_colors[TIC_PALETTE_SIZE];
+    u8 trans_colors[TIC_PALETTE_SIZE];
     u8 trans_count = 0;
     if (argn > 3)
     {
@@ -316,7 +317,7 @@ s7_pointer scheme_map(s7_scheme* sc, s7_pointer args)
 
     const int argn = s7_list_length(sc, args);
 
-    static u8 trans_colors[TIC_PALETTE_SIZE];
+    u8 trans_colors[TIC_PALETTE_SIZE];
     u8 trans_count = 0;
     if (argn > 6) {
         s7_pointer colorkey = s7_list_ref(sc, args, 6);
@@ -480,6 +481,12 @@ s7_pointer scheme_tstamp(s7_scheme* sc, s7_pointer args)
     tic_mem* tic = (tic_mem*)getSchemeCore(sc);
     return s7_make_integer(sc, tic_api_tstamp(tic));
 }
+s7_pointer scheme_cpu(s7_scheme* sc, s7_pointer args)
+{
+    // cpu() -> ms
+    tic_mem* tic = (tic_mem*)getSchemeCore(sc);
+    return s7_make_real(sc, tic_api_cpu(tic));
+}
 s7_pointer scheme_exit(s7_scheme* sc, s7_pointer args)
 {
     // exit()
@@ -495,7 +502,7 @@ s7_pointer scheme_font(s7_scheme* sc, s7_pointer args)
     const s32 x = s7_integer(s7_cadr(args));
     const s32 y = s7_integer(s7_caddr(args));
 
-    static u8 trans_colors[TIC_PALETTE_SIZE];
+    u8 trans_colors[TIC_PALETTE_SIZE];
     u8 trans_count = 0;
     s7_pointer colorkey = s7_cadddr(args);
     parseTransparentColorsArg(sc, colorkey, trans_colors, &trans_count);
@@ -620,7 +627,7 @@ s7_pointer scheme_ttri(s7_scheme* sc, s7_pointer args)
     const int argn = s7_list_length(sc, args);
     const tic_texture_src texsrc = (tic_texture_src)(argn > 12 ? s7_integer(s7_list_ref(sc, args, 12)) : 0);
     
-    static u8 trans_colors[TIC_PALETTE_SIZE];
+    u8 trans_colors[TIC_PALETTE_SIZE];
     u8 trans_count = 0;
 
     if (argn > 13)
@@ -807,6 +814,17 @@ static const char* defstructStr = "  \n\
                   (reverse functions))))) \n\
 ";
 
+// blocks between the budget checks
+#define SCHEME_BUDGET_COUNT 256
+
+// s7 calls it at the start of every block, the evaluation is dropped when it's set
+static void schemeBudgetHook(s7_scheme* sc, bool* val)
+{
+    tic_core* core = getSchemeCore(sc);
+
+    *val = ++core->budget.count % SCHEME_BUDGET_COUNT == 0 && tic_core_budget_over(core);
+}
+
 static bool initScheme(tic_mem* tic, const char* code)
 {
     tic_core* core = (tic_core*)tic;
@@ -824,8 +842,19 @@ static bool initScheme(tic_mem* tic, const char* code)
     s7_eval_c_string(sc, defstructStr);
 
     s7_define_variable(sc, TicCore, s7_make_c_pointer(sc, core));
+
+    if (core->data && core->data->budget)
+        s7_set_begin_hook(sc, schemeBudgetHook);
+
+    tic_core_budget_arm(core);
     s7_load_c_string(sc, code, strlen(code));
-    
+
+    if (tic_core_budget_over(core))
+    {
+        core->data->error(core->data->data, tic_core_budget_report(core));
+        return false;
+    }
+
 
     const bool isTicDefined = s7_is_defined(sc, ticFnName);
     if (!isTicDefined) {
@@ -21,6 +21,7 @@
 // SOFTWARE.
 
 #include "core/core.h"
+#include "core/profile.h"
 
 #if defined(TIC_BUILD_WITH_SQUIRREL)
 
@@ -481,7 +482,7 @@ static SQInteger squirrel_ttri(HSQUIRRELVM vm)
             pt[i] = getSquirrelFloat(vm, i + 2);
 
         tic_mem* tic = (tic_mem*)getSquirrelCore(vm);
-        static u8 colors[TIC_PALETTE_SIZE];
+        u8 colors[TIC_PALETTE_SIZE];
         s32 count = 0;
         tic_texture_src src = tic_tiles_texture;
 
@@ -637,7 +638,7 @@ static SQInteger squirrel_spr(HSQUIRRELVM vm)
     s32 scale = 1;
     tic_flip flip = tic_no_flip;
     tic_rotate rotate = tic_no_rotate;
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
 
     if(top >= 2) 
@@ -800,7 +801,7 @@ static SQInteger squirrel_map(HSQUIRRELVM vm)
     s32 sx = 0;
     s32 sy = 0;
     s32 scale = 1;
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
 
     SQInteger top = sq_gettop(vm);
@@ -1408,6 +1409,15 @@ static SQInteger squirrel_time(HSQUIRRELVM vm)
     return 1;
 }
 
+static SQInteger squirrel_cpu(HSQUIRRELVM vm)
+{
+    tic_mem* tic = (tic_mem*)getSquirrelCore(vm);
+
+    sq_pushfloat(vm, (SQFloat)(tic_api_cpu(tic)));
+
+    return 1;
+}
+
 static SQInteger squirrel_tstamp(HSQUIRRELVM vm)
 {
     tic_mem* tic = (tic_mem*)getSquirrelCore(vm);
@@ -21,6 +21,7 @@
 // SOFTWARE.
 
 #include "core/core.h"
+#include "core/profile.h"
 #if defined(TIC_BUILD_WITH_WASM)
 
 #define dbg(...) printf(__VA_ARGS__)
@@ -139,9 +140,27 @@ M3Result wasm_dump(IM3Runtime runtime)
     return m3Err_none;
 }
 
+// the runtime with its parsed, linked and compiled module outlives a reset,
+// a restart with the same binary only puts back the linear memory and the
+// globals as they were right after the load
+typedef struct
+{
+    tic_core* core;
+    IM3Runtime runtime;
+
+    // the module points into the binary, so it gets its own copy
+    u8* binary;
+    s32 size;
+
+    // NULL when the module can't be restarted this way
+    u8* memory;
+    u32 memorySize;
+    M3Global* globals;
+} WasmVM;
+
 static tic_core* getWasmCore(IM3Runtime ctx)
 {
-    return (tic_core*)ctx->userdata;
+    return ((WasmVM*)ctx->userdata)->core;
 }
 
 m3ApiRawFunction(wasmtic_line)
@@ -879,6 +898,17 @@ m3ApiRawFunction(wasmtic_time)
     m3ApiSuccess();
 }
 
+m3ApiRawFunction(wasmtic_cpu)
+{
+    m3ApiReturnType  (float)
+
+    tic_mem* tic = (tic_mem*)getWasmCore(runtime);
+
+    m3ApiReturn(tic_api_cpu(tic));
+
+    m3ApiSuccess();
+}
+
 m3ApiRawFunction(wasmtic_tstamp)
 {
     m3ApiReturnType  (uint32_t)
@@ -956,55 +986,71 @@ m3ApiRawFunction(wasmtic_mouse)
 
 
 
+s32 wasm_timeout_check(void* udata)
+{
+    return tic_core_budget_over(((WasmVM*)udata)->core);
+}
+
+// wasm3 can't interrupt a running loop, so the budget is checked on every
+// API call instead, the real function is in the import userdata
+m3ApiRawFunction(wasmtic_budget)
+{
+    if (wasm_timeout_check(runtime->userdata))
+        m3ApiTrap(tic_core_budget_report(getWasmCore(runtime)));
+
+    return ((M3RawCall)_ctx->userdata)(runtime, _ctx, _sp, _mem);
+}
+
 M3Result linkTicAPI(IM3Module module)
 {
     M3Result result = m3Err_none;
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "btn",     "i(i)",          &wasmtic_btn)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "btnp",    "i(iii)",        &wasmtic_btnp)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "clip",    "v(iiii)",       &wasmtic_clip)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "cls",     "v(i)",          &wasmtic_cls)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "circ",    "v(iiii)",       &wasmtic_circ)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "circb",   "v(iiii)",       &wasmtic_circb)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "elli",    "v(iiiii)",      &wasmtic_elli)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "ellib",   "v(iiiii)",      &wasmtic_ellib)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "exit",    "v()",           &wasmtic_exit)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "fget",    "i(ii)",         &wasmtic_fget)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "fset",    "v(iii)",        &wasmtic_fset)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "font",    "i(*iiiiiiiii)", &wasmtic_font)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "key",     "i(i)",          &wasmtic_key)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "keyp",    "i(iii)",        &wasmtic_keyp)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "line",    "v(ffffi)",      &wasmtic_line)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "btn",     "i(i)",          &wasmtic_budget, &wasmtic_btn)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "btnp",    "i(iii)",        &wasmtic_budget, &wasmtic_btnp)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "clip",    "v(iiii)",       &wasmtic_budget, &wasmtic_clip)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "cls",     "v(i)",          &wasmtic_budget, &wasmtic_cls)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "circ",    "v(iiii)",       &wasmtic_budget, &wasmtic_circ)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "circb",   "v(iiii)",       &wasmtic_budget, &wasmtic_circb)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "elli",    "v(iiiii)",      &wasmtic_budget, &wasmtic_elli)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "ellib",   "v(iiiii)",      &wasmtic_budget, &wasmtic_ellib)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "exit",    "v()",           &wasmtic_budget, &wasmtic_exit)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "fget",    "i(ii)",         &wasmtic_budget, &wasmtic_fget)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "fset",    "v(iii)",        &wasmtic_budget, &wasmtic_fset)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "font",    "i(*iiiiiiiii)", &wasmtic_budget, &wasmtic_font)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "key",     "i(i)",          &wasmtic_budget, &wasmtic_key)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "keyp",    "i(iii)",        &wasmtic_budget, &wasmtic_keyp)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "line",    "v(ffffi)",      &wasmtic_budget, &wasmtic_line)));
     // TODO: needs a lot of help for all the optional arguments
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "map",     "v(iiiiiiiiii)", &wasmtic_map)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "memcpy",  "v(iii)",        &wasmtic_memcpy)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "memset",  "v(iii)",        &wasmtic_memset)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "mget",    "i(ii)",         &wasmtic_mget)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "mset",    "v(iii)",        &wasmtic_mset)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "mouse",   "v(*)",          &wasmtic_mouse)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "music",   "v(iiiiiii)",    &wasmtic_music)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "pix",     "i(iii)",        &wasmtic_pix)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "peek",    "i(ii)",         &wasmtic_peek)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "peek4",   "i(i)",          &wasmtic_peek4)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "peek2",   "i(i)",          &wasmtic_peek2)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "peek1",   "i(i)",          &wasmtic_peek1)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "pmem",    "i(iI)",         &wasmtic_pmem)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "poke",    "v(iii)",        &wasmtic_poke)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "poke4",   "v(ii)",         &wasmtic_poke4)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "poke2",   "v(ii)",         &wasmtic_poke2)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "poke1",   "v(ii)",         &wasmtic_poke1)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "print",   "i(*iiiiii)",    &wasmtic_print)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "rect",    "v(iiiii)",      &wasmtic_rect)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "rectb",   "v(iiiii)",      &wasmtic_rectb)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "sfx",     "v(iiiiiiii)",   &wasmtic_sfx)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "spr",     "v(iiiiiiiiii)", &wasmtic_spr)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "sync",    "v(iii)",        &wasmtic_sync)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "time",    "f()",           &wasmtic_time)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "tstamp",  "i()",           &wasmtic_tstamp)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "trace",   "v(*i)",         &wasmtic_trace)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "tri",     "v(ffffffi)",    &wasmtic_tri)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "trib",    "v(ffffffi)",    &wasmtic_trib)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "ttri",  "v(ffffffffffffiiifffi)",    &wasmtic_ttri)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "vbank",   "i(i)",          &wasmtic_vbank)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "map",     "v(iiiiiiiiii)", &wasmtic_budget, &wasmtic_map)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "memcpy",  "v(iii)",        &wasmtic_budget, &wasmtic_memcpy)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "memset",  "v(iii)",        &wasmtic_budget, &wasmtic_memset)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "mget",    "i(ii)",         &wasmtic_budget, &wasmtic_mget)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "mset",    "v(iii)",        &wasmtic_budget, &wasmtic_mset)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "mouse",   "v(*)",          &wasmtic_budget, &wasmtic_mouse)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "music",   "v(iiiiiii)",    &wasmtic_budget, &wasmtic_music)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "pix",     "i(iii)",        &wasmtic_budget, &wasmtic_pix)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "peek",    "i(ii)",         &wasmtic_budget, &wasmtic_peek)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "peek4",   "i(i)",          &wasmtic_budget, &wasmtic_peek4)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "peek2",   "i(i)",          &wasmtic_budget, &wasmtic_peek2)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "peek1",   "i(i)",          &wasmtic_budget, &wasmtic_peek1)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "pmem",    "i(iI)",         &wasmtic_budget, &wasmtic_pmem)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "poke",    "v(iii)",        &wasmtic_budget, &wasmtic_poke)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "poke4",   "v(ii)",         &wasmtic_budget, &wasmtic_poke4)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "poke2",   "v(ii)",         &wasmtic_budget, &wasmtic_poke2)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "poke1",   "v(ii)",         &wasmtic_budget, &wasmtic_poke1)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "print",   "i(*iiiiii)",    &wasmtic_budget, &wasmtic_print)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "rect",    "v(iiiii)",      &wasmtic_budget, &wasmtic_rect)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "rectb",   "v(iiiii)",      &wasmtic_budget, &wasmtic_rectb)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "sfx",     "v(iiiiiiii)",   &wasmtic_budget, &wasmtic_sfx)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "spr",     "v(iiiiiiiiii)", &wasmtic_budget, &wasmtic_spr)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "sync",    "v(iii)",        &wasmtic_budget, &wasmtic_sync)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "time",    "f()",           &wasmtic_budget, &wasmtic_time)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "cpu",     "f()",           &wasmtic_budget, &wasmtic_cpu)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "tstamp",  "i()",           &wasmtic_budget, &wasmtic_tstamp)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "trace",   "v(*i)",         &wasmtic_budget, &wasmtic_trace)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "tri",     "v(ffffffi)",    &wasmtic_budget, &wasmtic_tri)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "trib",    "v(ffffffi)",    &wasmtic_budget, &wasmtic_trib)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "ttri",  "v(ffffffffffffiiifffi)",    &wasmtic_budget, &wasmtic_ttri)));
+    _   (SuppressLookupFailure (m3_LinkRawFunctionEx (module, "env", "vbank",   "i(i)",          &wasmtic_budget, &wasmtic_vbank)));
 
 _catch:
   return result;
@@ -1021,11 +1067,105 @@ void deinitWasmRuntime( IM3Runtime runtime )
     IM3Environment env = runtime -> environment;
     printf("deiniting env %d\n", env);
 
-    tic_core* tic = getWasmCore(runtime);
     m3_FreeRuntime (runtime);
     m3_FreeEnvironment (env);
 }
 
+static void freeWasmVM(WasmVM* vm)
+{
+    if(vm->runtime)
+        deinitWasmRuntime(vm->runtime);
+
+    free(vm->binary);
+    free(vm->memory);
+    free(vm->globals);
+    free(vm);
+}
+
+static void releaseWasm(tic_mem* tic)
+{
+    tic_core* core = (tic_core*)tic;
+    freeWasmVM(core->spareVM);
+}
+
+// the data segments are i32.const offsets above the TIC RAM, it's filled
+// from the base RAM on every init
+static bool isWasmSegmentAboveRam(const M3DataSegment* segment)
+{
+    const u8* expr = segment->initExpr;
+
+    if(segment->initExprSize < 2 || expr[0] != 0x41)
+        return false;
+
+    u32 offset = 0, shift = 0;
+    u8 byte;
+
+    for(u32 i = 1; ; i++)
+    {
+        if(i >= segment->initExprSize || shift >= 35)
+            return false;
+
+        byte = expr[i];
+        offset |= (u32)(byte & 0x7f) << shift;
+        shift += 7;
+
+        if(!(byte & 0x80))
+            break;
+    }
+
+    // negative offsets fail the load anyway
+    if(shift < 32 && (byte & 0x40))
+        return false;
+
+    return offset >= TIC_RAM_SIZE;
+}
+
+// what the start function does is only known after it runs
+static bool isWasmRestartable(IM3Module module)
+{
+    if(module->startFunction >= 0)
+        return false;
+
+    for(u32 i = 0; i < module->numDataSegments; i++)
+        if(!isWasmSegmentAboveRam(&module->dataSegments[i]))
+            return false;
+
+    return true;
+}
+
+static void saveWasmImage(WasmVM* vm)
+{
+    IM3Module module = vm->runtime->modules;
+
+    u32 size = 0;
+    u8* mem = m3_GetMemory(vm->runtime, &size, 0);
+
+    vm->memory = malloc(size);
+    vm->memorySize = size;
+    vm->globals = malloc(sizeof(M3Global) * module->numGlobals + 1);
+
+    memcpy(vm->memory, mem, size);
+    memcpy(vm->globals, module->globals, sizeof(M3Global) * module->numGlobals);
+}
+
+static void loadWasmImage(WasmVM* vm)
+{
+    IM3Module module = vm->runtime->modules;
+
+    u32 size = 0;
+    u8* mem = m3_GetMemory(vm->runtime, &size, 0);
+
+    // the memory may have grown since the snapshot, the rest starts zeroed
+    u32 saved = MAX(MIN(size, vm->memorySize), TIC_RAM_SIZE);
+
+    memcpy(mem + TIC_RAM_SIZE, vm->memory + TIC_RAM_SIZE, saved - TIC_RAM_SIZE);
+
+    if(size > saved)
+        memset(mem + saved, 0, size - saved);
+
+    memcpy(module->globals, vm->globals, sizeof(M3Global) * module->numGlobals);
+}
+
 static void closeWasm(tic_mem* tic)
 {
     tic_core* core = (tic_core*)tic;
@@ -1047,40 +1187,89 @@ static void closeWasm(tic_mem* tic)
         u8* low_ram =  (u8*)core->memory.base_ram;
         u8* wasm_ram = m3_GetMemory(core->currentVM, NULL, 0);
         memcpy(low_ram, wasm_ram, TIC_RAM_SIZE);
-        deinitWasmRuntime(core->currentVM);
+
+        WasmVM* vm = ((IM3Runtime)core->currentVM)->userdata;
+
+        if(vm->memory)
+            core->spareVM = vm;
+        else
+            freeWasmVM(vm);
+
         core->currentVM = NULL;
         core->memory.ram = NULL;
     }
 }
 
-// TODO: restore functionality
-// static u64 ForceExitCounter = 0;
 
-// s32 wasm_timeout_check(void* udata)
-// {
-//     tic_core* core = (tic_core*)udata;
-//     tic_tick_data* tick = core->data;
+static bool findWasmFunctions(tic_core* core, IM3Runtime runtime)
+{
+    m3_FindFunction (&BDR_function, runtime, BDR_FN);
+    m3_FindFunction (&SCN_function, runtime, SCN_FN);
+    m3_FindFunction (&BOOT_function, runtime, BOOT_FN);
+    m3_FindFunction (&MENU_function, runtime, MENU_FN);
+    M3Result result = m3_FindFunction (&TIC_function, runtime, TIC_FN);
 
-//     return ForceExitCounter++ > 1000 ? tick->forceExit && tick->forceExit(tick->data) : false;
-// }
+    if (result)
+    {
+        core->data->error(core->data->data, "Error: WASM must export a TIC function.");
+        return false;
+    }
 
+    return true;
+}
+
+static bool restartWasm(tic_core* core, WasmVM* vm)
+{
+    dbg("Restarting WASM3 runtime %p\n", core);
+
+    vm->core = core;
+
+    u8* low_ram =  (u8*)core->memory.ram;
+    u8* wasm_ram = m3_GetMemory(vm->runtime, NULL, 0);
+    memcpy(wasm_ram, low_ram, TIC_RAM_SIZE);
+    loadWasmImage(vm);
+
+    core->memory.ram = (tic_ram*)wasm_ram;
+    core->currentVM = vm->runtime;
+
+    tic_core_budget_arm(core);
+    return findWasmFunctions(core, vm->runtime);
+}
 
 static bool initWasm(tic_mem* tic, const char* code)
 {
     // closeWasm(tic);
     tic_core* core = (tic_core*)tic;
+
+    WasmVM* spare = core->spareVM;
+    core->spareVM = NULL;
+
+    if(spare)
+    {
+        if(spare->size == tic->cart.binary.size && memcmp(spare->binary, tic->cart.binary.data, spare->size) == 0)
+            return restartWasm(core, spare);
+
+        freeWasmVM(spare);
+    }
+
     dbg("Initializing WASM3 runtime %d\n", core);
 
+    WasmVM* vm = calloc(1, sizeof(WasmVM));
+    vm->core = core;
+
     IM3Environment env = m3_NewEnvironment ();
     if(!env)
     {
         core->data->error(core->data->data, "Unable to init WASM env");
+        free(vm);
         return false;
     }
-    IM3Runtime runtime = m3_NewRuntime (env, WASM_STACK_SIZE, core);
+    IM3Runtime runtime = vm->runtime = m3_NewRuntime (env, WASM_STACK_SIZE, vm);
     if(!runtime)
     {
         core->data->error(core->data->data, "Unable to init WASM runtime");
+        m3_FreeEnvironment(env);
+        free(vm);
         return false;
     }
 
@@ -1107,11 +1296,12 @@ static bool initWasm(tic_mem* tic, const char* code)
     //  return false;
     // }
 
-    void* wasmcode = tic->cart.binary.data;
     // TODO: will this blow up or have bad effects if we are zero-padded?
     // if so we'll need to find a way to pass in size here
     // int fsize = TIC_BINARY_SIZE;
-    int fsize = tic->cart.binary.size;
+    int fsize = vm->size = tic->cart.binary.size;
+    void* wasmcode = vm->binary = malloc(fsize);
+    memcpy(wasmcode, tic->cart.binary.data, fsize);
 
     IM3Module module;
     M3Result result = m3_ParseModule (runtime->environment, &module, wasmcode, fsize);
@@ -1134,17 +1324,16 @@ static bool initWasm(tic_mem* tic, const char* code)
         return false;
     }
 
-    m3_FindFunction (&BDR_function, runtime, BDR_FN);
-    m3_FindFunction (&SCN_function, runtime, SCN_FN);
-    m3_FindFunction (&BOOT_function, runtime, BOOT_FN);
-    m3_FindFunction (&MENU_function, runtime, MENU_FN);
-    result = m3_FindFunction (&TIC_function, runtime, TIC_FN);
+    bool restartable = isWasmRestartable(runtime->modules);
 
-    if (result)
-    {
-        core->data->error(core->data->data, "Error: WASM must export a TIC function.");
+    // looking the functions up runs the module's start function
+    tic_core_budget_arm(core);
+
+    if(!findWasmFunctions(core, runtime))
         return false;
-    }
+
+    if(restartable)
+        saveWasmImage(vm);
 
     return true;
 }
@@ -1275,6 +1464,36 @@ static const tic_outline_item* getWasmOutline(const char* code, s32* size)
     return items;
 }
 
+// the low TIC_RAM_SIZE bytes of the linear memory are tic_ram and go into the
+// savestate with it, the rest is the cart heap, data and shadow stack; mutable
+// globals are left alone, the stack pointer is back at its base between ticks
+static s32 getWasmStateSize(tic_mem* tic)
+{
+    tic_core* core = (tic_core*)tic;
+    u32 size = 0;
+    m3_GetMemory(core->currentVM, &size, 0);
+
+    return size - TIC_RAM_SIZE;
+}
+
+static void saveWasmState(tic_mem* tic, void* buffer)
+{
+    tic_core* core = (tic_core*)tic;
+    u32 size = 0;
+    u8* mem = m3_GetMemory(core->currentVM, &size, 0);
+
+    memcpy(buffer, mem + TIC_RAM_SIZE, size - TIC_RAM_SIZE);
+}
+
+static void loadWasmState(tic_mem* tic, const void* buffer)
+{
+    tic_core* core = (tic_core*)tic;
+    u32 size = 0;
+    u8* mem = m3_GetMemory(core->currentVM, &size, 0);
+
+    memcpy(mem + TIC_RAM_SIZE, buffer, size - TIC_RAM_SIZE);
+}
+
 void evalWasm(tic_mem* tic, const char* code) {
     printf("TODO: Wasm eval not yet implemented\n.");
 }
@@ -1288,6 +1507,7 @@ const tic_script_config WasmSyntaxConfig =
     {
       .init               = initWasm,
       .close              = closeWasm,
+      .release            = releaseWasm,
       .tick               = callWasmTick,
       .boot               = callWasmBoot,
 
@@ -1302,6 +1522,13 @@ const tic_script_config WasmSyntaxConfig =
     .getOutline         = getWasmOutline,
     .eval               = evalWasm,
 
+    .state              =
+    {
+        .size           = getWasmStateSize,
+        .save           = saveWasmState,
+        .load           = loadWasmState,
+    },
+
     .blockCommentStart  = "(;",
     .blockCommentEnd    = ";)",
     .blockCommentStart2 = NULL,
@@ -21,6 +21,7 @@
 // SOFTWARE.
 
 #include "core/core.h"
+#include "core/profile.h"
 
 #if defined(TIC_BUILD_WITH_WREN)
 
@@ -133,6 +134,7 @@ class TIC {\n\
     foreign static music(track, frame, row, loop, sustain, tempo, speed)\n\
     foreign static time()\n\
     foreign static tstamp()\n\
+    foreign static cpu()\n\
     foreign static vbank()\n\
     foreign static vbank(bank)\n\
     foreign static sync()\n\
@@ -544,7 +546,7 @@ static void wren_spr(WrenVM* vm)
     s32 scale = 1;
     tic_flip flip = tic_no_flip;
     tic_rotate rotate = tic_no_rotate;
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
 
     if(top > 1)
@@ -619,7 +621,7 @@ static void wren_spr_internal(WrenVM* vm)
     s32 x = getWrenNumber(vm, 2);
     s32 y = getWrenNumber(vm, 3);
 
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
 
     if(isList(vm, 4))
@@ -664,7 +666,7 @@ static void wren_map(WrenVM* vm)
     s32 sx = 0;
     s32 sy = 0;
     s32 scale = 1;
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
 
     s32 top = wrenGetSlotCount(vm);
@@ -779,7 +781,7 @@ static void wren_ttri(WrenVM* vm)
     }
 
     tic_mem* tic = (tic_mem*)getWrenCore(vm);
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
     tic_texture_src src = tic_tiles_texture;
 
@@ -841,7 +843,7 @@ static void wren_textri(WrenVM* vm)
 
     tic_core* core = getWrenCore(vm);
     tic_mem* tic = (tic_mem*)core;
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
     tic_texture_src src = tic_tiles_texture;
 
@@ -1341,6 +1343,13 @@ static void wren_tstamp(WrenVM* vm)
     wrenSetSlotDouble(vm, 0, tic_api_tstamp(tic));
 }
 
+static void wren_cpu(WrenVM* vm)
+{
+    tic_mem* tic = (tic_mem*)getWrenCore(vm);
+
+    wrenSetSlotDouble(vm, 0, tic_api_cpu(tic));
+}
+
 static void wren_vbank(WrenVM* vm)
 {
     tic_core* core = getWrenCore(vm);
@@ -1537,6 +1546,7 @@ static WrenForeignMethodFn foreignTicMethods(const char* signature)
 
     if (strcmp(signature, "static TIC.time()"                   ) == 0) return wren_time;
     if (strcmp(signature, "static TIC.tstamp()"                 ) == 0) return wren_tstamp;
+    if (strcmp(signature, "static TIC.cpu()"                    ) == 0) return wren_cpu;
     if (strcmp(signature, "static TIC.vbank()"                  ) == 0) return wren_vbank;
     if (strcmp(signature, "static TIC.vbank(_)"                 ) == 0) return wren_vbank;
     if (strcmp(signature, "static TIC.sync()"                   ) == 0) return wren_sync;
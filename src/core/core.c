@@ -38,6 +38,14 @@
 #include <3ds.h>
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define TIC_BLIT_SSE2
+#   include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#   define TIC_BLIT_NEON
+#   include <arm_neon.h>
+#endif
+
 static_assert(TIC_BANK_BITS == 3,                   "tic_bank_bits");
 static_assert(sizeof(tic_map) < 1024 * 32,          "tic_map");
 static_assert(sizeof(tic_rgb) == 3,    "tic_rgb");
@@ -242,6 +250,63 @@ s32 tic_api_tstamp(tic_mem* memory)
     return (s32)time(NULL);
 }
 
+static double budgetTime(tic_core* core)
+{
+    return (double)(core->data->counter(core->data->data) - core->budget.start) * 1000.0 / core->data->freq(core->data->data);
+}
+
+double tic_api_cpu(tic_mem* memory)
+{
+    return budgetTime((tic_core*)memory);
+}
+
+static void beginBudget(tic_core* core, bool armed)
+{
+    tic_script_budget* budget = &core->budget;
+    const tic_tick_data* data = core->data;
+
+    budget->start = data->counter(data->data);
+    budget->deadline = armed && data->budget ? budget->start + data->budget * data->freq(data->data) / 1000 : 0;
+    budget->over = budget->reported = false;
+}
+
+void tic_core_budget_arm(tic_core* core)
+{
+    beginBudget(core, true);
+}
+
+bool tic_core_budget_over(tic_core* core)
+{
+    tic_script_budget* budget = &core->budget;
+
+    if (budget->deadline && !budget->over)
+        budget->over = core->data->counter(core->data->data) > budget->deadline;
+
+    return budget->over;
+}
+
+const char* tic_core_budget_report(tic_core* core)
+{
+    tic_script_budget* budget = &core->budget;
+
+    snprintf(budget->report, sizeof budget->report,
+        "the frame took %.1f ms of its %u ms script budget", budgetTime(core), core->data->budget);
+
+    budget->reported = true;
+    return budget->report;
+}
+
+// the code the VM hooks didn't stop is reported here, the limit is off
+// until the next tick so the menu and console calls aren't cut
+static void endBudget(tic_core* core)
+{
+    if (tic_core_budget_over(core) && !core->budget.reported)
+        core->data->error(core->data->data, tic_core_budget_report(core));
+
+    core->budget.deadline = 0;
+    core->budget.over = false;
+}
+
 static bool compareMetatag(const char* code, const char* tag, const char* value, const char* comment)
 {
     bool result = false;
@@ -383,6 +448,9 @@ void tic_api_reset(tic_mem* memory)
     soundClear(memory);
     updateSaveid(memory);
     font2ram(memory);
+
+    if(core->rewind.history)
+        rewind_clear(core->rewind.history);
 }
 
 static void cart2ram(tic_mem* memory)
@@ -417,9 +485,23 @@ static void tic_close_current_vm(tic_core* core)
     }
 }
 
+static void tic_release_spare_vm(tic_core* core)
+{
+    if(core->spareVM)
+    {
+        core->currentScript->release((tic_mem*)core);
+        core->spareVM = NULL;
+    }
+}
+
 static bool tic_init_vm(tic_core* core, const char* code, const tic_script_config* config)
 {
     tic_close_current_vm(core);
+
+    // only the language that closed the VM can take it back
+    if(core->currentScript != config)
+        tic_release_spare_vm(core);
+
     // set current script config and init
     core->currentScript = config;
     bool done = config->init( (tic_mem*) core , code);
@@ -492,7 +574,14 @@ void tic_core_tick(tic_mem* tic, tic_tick_data* data)
                 code = tic->cart.binary.data;
             }
 
+            // the deadline is off while the code compiles, cpu() counts from here
+            beginBudget(core, false);
+
+            core->init.cached = false;
             done = tic_init_vm(core, code, config);
+
+            core->init.freq = data->freq(core->data->data);
+            core->init.time = data->counter(core->data->data) - data->start;
         }
         else
         {
@@ -501,15 +590,24 @@ void tic_core_tick(tic_mem* tic, tic_tick_data* data)
 
         if (done)
         {
+            beginBudget(core, true);
+
             config->boot(tic);
             core->state.tick = config->tick;
             core->state.callback = config->callback;
             core->state.initialized = true;
         }
-        else return;
+        else
+        {
+            endBudget(core);
+            return;
+        }
     }
+    else beginBudget(core, true);
 
+    tic_core_profile_begin(tic);
     core->state.tick(tic);
+    tic_core_profile_stage(tic, tic_profile_tic);
 }
 
 void tic_core_pause(tic_mem* memory)
@@ -544,6 +642,280 @@ void tic_core_resume(tic_mem* memory)
     }
 }
 
+// savestate layout: StateHeader, tic_ram, tic_core_state_data and
+// header.vm bytes of script VM state when the language can snapshot it
+#define StateMagic "TICS"
+enum { StateVersion = 1 };
+
+typedef struct
+{
+    char magic[4];
+    u32 version;
+    u32 state;
+    u32 vm;
+    u8 lang;
+
+    // music delay rows are pointers into the patterns, stored as indices, -1 if none
+    s32 delay[TIC_SOUND_CHANNELS];
+} StateHeader;
+
+static inline const tic_script_config* stateScript(tic_core* core)
+{
+    return core->currentVM && core->currentScript && core->currentScript->state.size
+        ? core->currentScript : NULL;
+}
+
+s32 tic_core_state_size(tic_mem* memory)
+{
+    const tic_script_config* script = stateScript((tic_core*)memory);
+
+    return sizeof(StateHeader) + sizeof(tic_ram) + sizeof(tic_core_state_data)
+        + (script ? script->state.size(memory) : 0);
+}
+
+bool tic_core_state_vm(tic_mem* memory)
+{
+    return stateScript((tic_core*)memory) != NULL;
+}
+
+bool tic_core_state_save(tic_mem* memory, void* buffer, s32 size)
+{
+    tic_core* core = (tic_core*)memory;
+    const tic_script_config* script = stateScript(core);
+
+    if(size < tic_core_state_size(memory))
+        return false;
+
+    StateHeader* header = buffer;
+    *header = (StateHeader)
+    {
+        .magic = StateMagic,
+        .version = StateVersion,
+        .state = sizeof(tic_core_state_data),
+        .vm = script ? script->state.size(memory) : 0,
+        .lang = core->currentScript ? core->currentScript->id : 0,
+    };
+
+    const tic_track_row* rows = memory->ram->music.patterns.data->rows;
+    for(s32 i = 0; i < TIC_SOUND_CHANNELS; i++)
+    {
+        const tic_track_row* row = core->state.music.commands[i].delay.row;
+        header->delay[i] = row ? (s32)(row - rows) : -1;
+    }
+
+    u8* ptr = (u8*)(header + 1);
+    memcpy(ptr, memory->ram, sizeof(tic_ram));
+    ptr += sizeof(tic_ram);
+    memcpy(ptr, &core->state, sizeof(tic_core_state_data));
+    ptr += sizeof(tic_core_state_data);
+
+    if(script)
+        script->state.save(memory, ptr);
+
+    return true;
+}
+
+bool tic_core_state_load(tic_mem* memory, const void* buffer, s32 size)
+{
+    tic_core* core = (tic_core*)memory;
+    const tic_script_config* script = stateScript(core);
+    const StateHeader* header = buffer;
+
+    enum { Rows = sizeof(tic_patterns) / sizeof(tic_track_row) };
+
+    if(size < sizeof(StateHeader)
+        || memcmp(header->magic, StateMagic, sizeof header->magic)
+        || header->version != StateVersion
+        || header->state != sizeof(tic_core_state_data)
+        || size != sizeof(StateHeader) + sizeof(tic_ram) + sizeof(tic_core_state_data) + header->vm)
+        return false;
+
+    // VM state only fits the same language and memory layout it was taken from
+    if(header->vm && (!script || script->id != header->lang || script->state.size(memory) != header->vm))
+        return false;
+
+    for(s32 i = 0; i < TIC_SOUND_CHANNELS; i++)
+        if(header->delay[i] >= Rows)
+            return false;
+
+    const u8* ptr = (const u8*)(header + 1);
+    memcpy(memory->ram, ptr, sizeof(tic_ram));
+    ptr += sizeof(tic_ram);
+
+    // function pointers and the VM bound state stay with this instance
+    tic_tick tick = core->state.tick;
+    tic_blit_callback callback = core->state.callback;
+    bool initialized = core->state.initialized;
+    tic_sound_register_data left[TIC_SOUND_CHANNELS], right[TIC_SOUND_CHANNELS];
+    memcpy(left, core->state.registers.left, sizeof left);
+    memcpy(right, core->state.registers.right, sizeof right);
+
+    memcpy(&core->state, ptr, sizeof(tic_core_state_data));
+    ptr += sizeof(tic_core_state_data);
+
+    core->state.tick = tick;
+    core->state.callback = callback;
+    core->state.initialized = initialized;
+
+    // the state may come from an instance with another latency
+    core->state.sound_ringbuf_head %= core->sound.ringlen;
+    core->state.sound_ringbuf_tail %= core->sound.ringlen;
+
+    const tic_track_row* rows = memory->ram->music.patterns.data->rows;
+    for(s32 i = 0; i < TIC_SOUND_CHANNELS; i++)
+    {
+        core->state.sfx.channels[i].pos = &memory->ram->sfxpos[i];
+        core->state.music.channels[i].pos = &core->state.music.sfxpos[i];
+        core->state.music.commands[i].delay.row = header->delay[i] < 0 ? NULL : rows + header->delay[i];
+
+        // the blip buffers keep integrating from the old levels, step them to the restored ones
+        blip_add_delta(core->blip.left, 0, core->state.registers.left[i].amp - left[i].amp);
+        blip_add_delta(core->blip.right, 0, core->state.registers.right[i].amp - right[i].amp);
+
+        if(core->sound.bus.samples)
+        {
+            blip_add_delta(core->sound.bus.left[i], 0, core->state.registers.left[i].amp - left[i].amp);
+            blip_add_delta(core->sound.bus.right[i], 0, core->state.registers.right[i].amp - right[i].amp);
+        }
+    }
+
+    if(header->vm)
+        script->state.load(memory, ptr);
+
+    return true;
+}
+
+static void freeRewind(tic_core* core)
+{
+    rewind_delete(core->rewind.history);
+    free(core->rewind.state);
+    core->rewind.history = NULL;
+    core->rewind.state = NULL;
+}
+
+// budget is the size of the delta ring in bytes, 0 turns rewinding off
+void tic_core_rewind_init(tic_mem* memory, u32 budget)
+{
+    tic_core* core = (tic_core*)memory;
+
+    freeRewind(core);
+    core->rewind.budget = budget;
+}
+
+// snapshots are taken in the middle of the frame, after the script tick and
+// before tick_end, and tic_core_rewind_back is meant for the same spot
+void tic_core_rewind_push(tic_mem* memory)
+{
+    tic_core* core = (tic_core*)memory;
+
+    if(!core->rewind.budget)
+        return;
+
+    u32 size = tic_core_state_size(memory);
+
+    // the state grows once the script VM is up, start a new history then
+    if(core->rewind.history && rewind_size(core->rewind.history) != size)
+        freeRewind(core);
+
+    if(!core->rewind.history)
+    {
+        core->rewind.history = rewind_create(size, core->rewind.budget);
+        core->rewind.state = malloc(size);
+    }
+
+    tic_core_state_save(memory, core->rewind.state, size);
+    rewind_add(core->rewind.history, core->rewind.state);
+}
+
+bool tic_core_rewind_back(tic_mem* memory)
+{
+    tic_core* core = (tic_core*)memory;
+
+    return core->rewind.history
+        && rewind_back(core->rewind.history, core->rewind.state)
+        && tic_core_state_load(memory, core->rewind.state, rewind_size(core->rewind.history));
+}
+
+static void cacheKey(char* key, s32 size, const char* kind, const void* src, s32 srcSize)
+{
+    // FNV-1a
+    u64 hash = 14695981039346656037ull;
+
+    for(const u8 *ptr = src, *end = ptr + srcSize; ptr < end; ptr++)
+        hash = (hash ^ *ptr) * 1099511628211ull;
+
+    snprintf(key, size, "%s-%016llx-%x", kind, (unsigned long long)hash, srcSize);
+}
+
+// takes the data, it replaces the item with the same key or the least recently used one
+static s32 cacheStore(tic_core* core, const char* key, void* data, s32 size)
+{
+    tic_script_cache* cache = &core->cache;
+    s32 index = 0;
+
+    for(s32 i = 1; i < COUNT_OF(cache->items); i++)
+        if(cache->items[i].used < cache->items[index].used)
+            index = i;
+
+    for(s32 i = 0; i < COUNT_OF(cache->items); i++)
+        if(cache->items[i].data && strcmp(cache->items[i].key, key) == 0)
+            index = i;
+
+    free(cache->items[index].data);
+
+    strncpy(cache->items[index].key, key, sizeof cache->items[index].key - 1);
+    cache->items[index].data = data;
+    cache->items[index].size = size;
+    cache->items[index].used = ++cache->clock;
+
+    return index;
+}
+
+const void* tic_core_cache_load(tic_core* core, const char* kind, const void* src, s32 srcSize, s32* size)
+{
+    tic_script_cache* cache = &core->cache;
+
+    char key[sizeof cache->items->key];
+    cacheKey(key, sizeof key, kind, src, srcSize);
+
+    s32 index = -1;
+
+    for(s32 i = 0; i < COUNT_OF(cache->items); i++)
+        if(cache->items[i].data && strcmp(cache->items[i].key, key) == 0)
+            index = i;
+
+    if(index < 0 && core->data && core->data->cacheLoad)
+    {
+        s32 loaded = 0;
+        void* data = core->data->cacheLoad(core->data->data, kind, key, &loaded);
+
+        if(data)
+            index = cacheStore(core, key, data, loaded);
+    }
+
+    if(index < 0)
+        return NULL;
+
+    cache->items[index].used = ++cache->clock;
+    *size = cache->items[index].size;
+    core->init.cached = true;
+
+    return cache->items[index].data;
+}
+
+void tic_core_cache_save(tic_core* core, const char* kind, const void* src, s32 srcSize, const void* data, s32 size)
+{
+    char key[sizeof core->cache.items->key];
+    cacheKey(key, sizeof key, kind, src, srcSize);
+
+    void* copy = malloc(size);
+    memcpy(copy, data, size);
+    cacheStore(core, key, copy, size);
+
+    if(core->data && core->data->cacheSave)
+        core->data->cacheSave(core->data->data, kind, key, data, size);
+}
+
 void tic_core_close(tic_mem* memory)
 {
     tic_core* core = (tic_core*)memory;
@@ -551,9 +923,16 @@ void tic_core_close(tic_mem* memory)
     core->state.initialized = false;
 
     tic_close_current_vm(core);
+    tic_release_spare_vm(core);
 
     blip_delete(core->blip.left);
     blip_delete(core->blip.right);
+    tic_core_sound_buses(memory, false);
+
+    freeRewind(core);
+
+    for(s32 i = 0; i < COUNT_OF(core->cache.items); i++)
+        free(core->cache.items[i].data);
 
 #ifdef _3DS
     linearFree(memory->product.screen);
@@ -564,9 +943,143 @@ void tic_core_close(tic_mem* memory)
     free(core);
 }
 
+const char* const ProfileStageNames[TIC_PROFILE_STAGES] =
+{
+#define TIC_PROFILE_STAGE_DEF(_, name) name,
+    TIC_PROFILE_STAGE_LIST(TIC_PROFILE_STAGE_DEF)
+#undef  TIC_PROFILE_STAGE_DEF
+};
+
+const char* const ApiNames[TIC_API_COUNT] =
+{
+#define API_NAME_DEF(name, ...) #name,
+    TIC_API_LIST(API_NAME_DEF)
+#undef  API_NAME_DEF
+};
+
+static inline bool profiling(tic_core* core)
+{
+    return (core->profiler.enabled || core->profiler.tracing) && core->data;
+}
+
+static void addProfileItem(tic_profile_item* dst, const tic_profile_item* src)
+{
+    dst->calls += src->calls;
+    dst->time += src->time;
+}
+
+static void endProfileItem(tic_core* core, tic_profile_item* item, tic_profile_stage stage, s32 arg)
+{
+    tic_profiler* profiler = &core->profiler;
+
+    if(profiling(core) && profiler->depth > 0 && --profiler->depth < TIC_PROFILE_DEPTH)
+    {
+        u64 start = profiler->start[profiler->depth];
+        u64 end = core->data->counter(core->data->data);
+
+        if(profiler->enabled)
+        {
+            item->calls++;
+            item->time += end - start;
+        }
+
+        // only the stages go to the trace, API calls would flood it
+        if(profiler->tracing && stage < TIC_PROFILE_STAGES)
+            tracing_add(profiler->tracing, ProfileStageNames[stage],
+                stage == tic_profile_synth ? TracingAudioThread : TracingMainThread, start, end, arg);
+    }
+}
+
+static void endProfileStage(tic_core* core, tic_profile_stage stage, s32 row)
+{
+    endProfileItem(core, &core->profiler.frame.stage[stage], stage, row);
+}
+
+void tic_core_profile_begin(tic_mem* memory)
+{
+    tic_core* core = (tic_core*)memory;
+    tic_profiler* profiler = &core->profiler;
+
+    if(profiling(core) && profiler->depth++ < TIC_PROFILE_DEPTH)
+        profiler->start[profiler->depth - 1] = core->data->counter(core->data->data);
+}
+
+void tic_core_profile_end(tic_mem* memory, s32 index)
+{
+    tic_core* core = (tic_core*)memory;
+    endProfileItem(core, &core->profiler.frame.api[index], TIC_PROFILE_STAGES, -1);
+}
+
+void tic_core_profile_stage(tic_mem* memory, tic_profile_stage stage)
+{
+    endProfileStage((tic_core*)memory, stage, -1);
+}
+
+void tic_core_profile(tic_mem* memory, bool enable)
+{
+    tic_profiler* profiler = &((tic_core*)memory)->profiler;
+    Tracing* tracing = profiler->tracing;
+
+    ZEROMEM(*profiler);
+    profiler->enabled = enable;
+    profiler->tracing = tracing;
+}
+
+const tic_profile_data* tic_core_profile_data(tic_mem* memory)
+{
+    tic_core* core = (tic_core*)memory;
+    return core->profiler.enabled ? &core->profiler.data : NULL;
+}
+
+const tic_script_init* tic_core_script_init(tic_mem* memory)
+{
+    return &((tic_core*)memory)->init;
+}
+
+// the stages are added to the trace until it's set to NULL, the caller owns it
+void tic_core_tracing(tic_mem* memory, Tracing* tracing)
+{
+    tic_core* core = (tic_core*)memory;
+    core->profiler.tracing = tracing;
+    core->profiler.depth = 0;
+}
+
+static void nextProfileFrame(tic_core* core)
+{
+    tic_profiler* profiler = &core->profiler;
+
+    if(profiler->enabled)
+    {
+        // frames where the cart didn't tick (console, editors) are dropped
+        if(profiler->frame.stage[tic_profile_tic].calls)
+        {
+            tic_profile_data* data = &profiler->data;
+
+            data->last = profiler->frame;
+            data->freq = core->data->freq(core->data->data);
+            data->frames++;
+
+            for(s32 i = 0; i < TIC_API_COUNT; i++)
+                addProfileItem(&data->total.api[i], &data->last.api[i]);
+
+            for(s32 i = 0; i < TIC_PROFILE_STAGES; i++)
+                addProfileItem(&data->total.stage[i], &data->last.stage[i]);
+        }
+
+        ZEROMEM(profiler->frame);
+    }
+
+    // a script error can leave a call unfinished
+    profiler->depth = 0;
+}
+
 void tic_core_tick_start(tic_mem* memory)
 {
     tic_core* core = (tic_core*)memory;
+
+    nextProfileFrame(core);
+    tic_core_profile_begin(memory);
+
     tic_core_sound_tick_start(memory);
     tic_core_tick_io(memory);
 
@@ -580,6 +1093,8 @@ void tic_core_tick_start(tic_mem* memory)
     core->state.gamepads.now.data = core->memory.ram->input.gamepads.data;
 
     core->state.synced = 0;
+
+    endProfileStage(core, tic_profile_start, -1);
 }
 
 void tic_core_tick_end(tic_mem* memory)
@@ -627,14 +1142,35 @@ static inline void memset4(void* dst, u32 val, u32 dwords)
 #endif
 }
 
-static inline void updpal(tic_mem* tic, tic_blitpal* pal0, tic_blitpal* pal1)
+// vbank0 colors go to [0, 16) and vbank1 colors to [16, 32)
+typedef struct
+{
+    u32 data[TIC_PALETTE_SIZE * 2];
+    tic_palette src[2];
+} BlitPalette;
+
+static inline void updpal(tic_mem* tic, BlitPalette* pal)
+{
+    tic_core* core = (tic_core*)tic;
+    const tic_palette* src0 = &vbank0(core)->palette;
+    const tic_palette* src1 = &vbank1(core)->palette;
+
+    tic_blitpal pal0 = tic_tool_palette_blit(src0, core->screen_format);
+    tic_blitpal pal1 = tic_tool_palette_blit(src1, core->screen_format);
+
+    memcpy(pal->data, pal0.data, sizeof pal0.data);
+    memcpy(pal->data + TIC_PALETTE_SIZE, pal1.data, sizeof pal1.data);
+    pal->src[0] = *src0;
+    pal->src[1] = *src1;
+}
+
+static inline bool samepal(tic_mem* tic, const BlitPalette* pal)
 {
     tic_core* core = (tic_core*)tic;
-    *pal0 = tic_tool_palette_blit(&vbank0(core)->palette, core->screen_format);
-    *pal1 = tic_tool_palette_blit(&vbank1(core)->palette, core->screen_format);
+    return MEMCMP(pal->src[0], vbank0(core)->palette) && MEMCMP(pal->src[1], vbank1(core)->palette);
 }
 
-static inline void updbdr(tic_mem* tic, s32 row, u32* ptr, tic_blit_callback clb, tic_blitpal* pal0, tic_blitpal* pal1)
+static inline u32 updbdr(tic_mem* tic, s32 row, tic_blit_callback clb, BlitPalette* pal)
 {
     tic_core* core = (tic_core*)tic;
 
@@ -647,93 +1183,188 @@ static inline void updbdr(tic_mem* tic, s32 row, u32* ptr, tic_blit_callback clb
             clb.scanline(tic, row - TIC80_MARGIN_TOP, clb.data);
     }
 
-    if(clb.border || clb.scanline)
-        updpal(tic, pal0, pal1);
+    // scanline callbacks rarely touch the palette, skip the conversion then
+    if((clb.border || clb.scanline) && !samepal(tic, pal))
+        updpal(tic, pal);
 
-    memset4(ptr, pal0->data[vbank0(core)->vars.border], TIC80_FULLWIDTH);
+    return pal->data[vbank0(core)->vars.border];
 }
 
-static inline u32 blitpix(tic_mem* tic, s32 offset0, s32 offset1, const tic_blitpal* pal0, const tic_blitpal* pal1)
+enum { RowBytes = TIC80_WIDTH * TIC_PALETTE_BPP / BITS_IN_BYTE };
+
+// unpacks a screen row to one palette index per byte
+static inline void unpackRow(const u8* src, u8* dst)
 {
-    tic_core* core = (tic_core*)tic;
-    u32 pix = tic_tool_peek4(vbank1(core)->screen.data, offset1);
+    s32 i = 0;
+
+#if defined(TIC_BLIT_SSE2)
+    const __m128i mask = _mm_set1_epi8(0x0f);
 
-    return pix != vbank1(core)->vars.clear
-        ? pal1->data[pix]
-        : pal0->data[tic_tool_peek4(vbank0(core)->screen.data, offset0)];
+    for(; i + 16 <= RowBytes; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i lo = _mm_and_si128(v, mask);
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+        _mm_storeu_si128((__m128i*)(dst + i * 2), _mm_unpacklo_epi8(lo, hi));
+        _mm_storeu_si128((__m128i*)(dst + i * 2 + 16), _mm_unpackhi_epi8(lo, hi));
+    }
+#elif defined(TIC_BLIT_NEON)
+    const uint8x16_t mask = vdupq_n_u8(0x0f);
+
+    for(; i + 16 <= RowBytes; i += 16)
+    {
+        uint8x16_t v = vld1q_u8(src + i);
+        uint8x16x2_t r = vzipq_u8(vandq_u8(v, mask), vshrq_n_u8(v, 4));
+        vst1q_u8(dst + i * 2, r.val[0]);
+        vst1q_u8(dst + i * 2 + 16, r.val[1]);
+    }
+#endif
+
+    for(; i < RowBytes; i++)
+    {
+        dst[i * 2] = src[i] & 0x0f;
+        dst[i * 2 + 1] = src[i] >> 4;
+    }
+}
+
+// composites vbank1 indices over vbank0 ones and expands them through the palette
+static inline void blitRow(u32* dst, const u8* idx0, const u8* idx1, u8 clear, const BlitPalette* pal)
+{
+    u8 idx[TIC80_WIDTH];
+    s32 i = 0;
+
+#if defined(TIC_BLIT_SSE2)
+    const __m128i key = _mm_set1_epi8(clear);
+    const __m128i bank1 = _mm_set1_epi8(TIC_PALETTE_SIZE);
+
+    for(; i + 16 <= TIC80_WIDTH; i += 16)
+    {
+        __m128i v0 = _mm_loadu_si128((const __m128i*)(idx0 + i));
+        __m128i v1 = _mm_loadu_si128((const __m128i*)(idx1 + i));
+        __m128i m = _mm_cmpeq_epi8(v1, key);
+        _mm_storeu_si128((__m128i*)(idx + i), 
+            _mm_or_si128(_mm_and_si128(m, v0), _mm_andnot_si128(m, _mm_or_si128(v1, bank1))));
+    }
+#elif defined(TIC_BLIT_NEON)
+    const uint8x16_t key = vdupq_n_u8(clear);
+    const uint8x16_t bank1 = vdupq_n_u8(TIC_PALETTE_SIZE);
+
+    for(; i + 16 <= TIC80_WIDTH; i += 16)
+    {
+        uint8x16_t v0 = vld1q_u8(idx0 + i);
+        uint8x16_t v1 = vld1q_u8(idx1 + i);
+        vst1q_u8(idx + i, vbslq_u8(vceqq_u8(v1, key), v0, vorrq_u8(v1, bank1)));
+    }
+#endif
+
+    for(; i < TIC80_WIDTH; i++)
+        idx[i] = idx1[i] != clear ? idx1[i] | TIC_PALETTE_SIZE : idx0[i];
+
+    for(i = 0; i < TIC80_WIDTH; i++)
+        dst[i] = pal->data[idx[i]];
 }
 
 void tic_core_blit_ex(tic_mem* tic, tic_blit_callback clb)
 {
     tic_core* core = (tic_core*)tic;
 
-    tic_blitpal pal0, pal1;
-    updpal(tic, &pal0, &pal1);
+    tic_core_profile_begin(tic);
+
+    BlitPalette pal;
+    updpal(tic, &pal);
 
     s32 row = 0;
     u32* rowPtr = tic->product.screen;
 
-#define UPDBDR() updbdr(tic, row, rowPtr, clb, &pal0, &pal1)
+    // rows are unpacked twice in a row, so a row scrolled by X is a contiguous slice
+    u8 row0[TIC80_WIDTH * 2], row1[TIC80_WIDTH * 2];
+
+#define UPDBDR() updbdr(tic, row, clb, &pal)
 
     for(; row != TIC80_MARGIN_TOP; ++row, rowPtr += TIC80_FULLWIDTH)
-        UPDBDR();
+        memset4(rowPtr, UPDBDR(), TIC80_FULLWIDTH);
 
     for(; row != TIC80_FULLHEIGHT - TIC80_MARGIN_BOTTOM; ++row)
     {
-        UPDBDR();
+        // only the side borders are filled, the screen row is written over the rest
+        u32 border = UPDBDR();
+        memset4(rowPtr, border, TIC80_MARGIN_LEFT);
+        memset4(rowPtr + TIC80_MARGIN_LEFT + TIC80_WIDTH, border, TIC80_MARGIN_RIGHT);
         rowPtr += TIC80_MARGIN_LEFT;
 
-        if(*(u16*)&vbank0(core)->vars.offset == 0 && *(u16*)&vbank1(core)->vars.offset == 0)
+        const tic_vram* bank0 = vbank0(core);
+        const tic_vram* bank1 = vbank1(core);
+
+        if(*(u16*)&bank0->vars.offset == 0 && *(u16*)&bank1->vars.offset == 0)
         {
             // render line without XY offsets
-            for(s32 x = (row - TIC80_MARGIN_TOP) * TIC80_WIDTH, end = x + TIC80_WIDTH; x != end; ++x)
-                *rowPtr++ = blitpix(tic, x, x, &pal0, &pal1);
+            s32 start = (row - TIC80_MARGIN_TOP) * RowBytes;
+
+            unpackRow(bank0->screen.data + start, row0);
+            unpackRow(bank1->screen.data + start, row1);
+            blitRow(rowPtr, row0, row1, bank1->vars.clear, &pal);
         }
         else
         {
             // render line with XY offsets
             enum{OffsetY = TIC80_HEIGHT - TIC80_MARGIN_TOP};
-            s32 start0 = (row + vbank0(core)->vars.offset.y + OffsetY) % TIC80_HEIGHT * TIC80_WIDTH;
-            s32 start1 = (row + vbank1(core)->vars.offset.y + OffsetY) % TIC80_HEIGHT * TIC80_WIDTH;
-            s32 offsetX0 = vbank0(core)->vars.offset.x;
-            s32 offsetX1 = vbank1(core)->vars.offset.x;
-
-            for(s32 x = TIC80_WIDTH; x != 2 * TIC80_WIDTH; ++x)
-                *rowPtr++ = blitpix(tic, (x + offsetX0) % TIC80_WIDTH + start0, 
-                    (x + offsetX1) % TIC80_WIDTH + start1, &pal0, &pal1);
+            s32 start0 = (row + bank0->vars.offset.y + OffsetY) % TIC80_HEIGHT * RowBytes;
+            s32 start1 = (row + bank1->vars.offset.y + OffsetY) % TIC80_HEIGHT * RowBytes;
+            s32 offsetX0 = (bank0->vars.offset.x + TIC80_WIDTH) % TIC80_WIDTH;
+            s32 offsetX1 = (bank1->vars.offset.x + TIC80_WIDTH) % TIC80_WIDTH;
+
+            unpackRow(bank0->screen.data + start0, row0);
+            unpackRow(bank1->screen.data + start1, row1);
+            memcpy(row0 + TIC80_WIDTH, row0, TIC80_WIDTH);
+            memcpy(row1 + TIC80_WIDTH, row1, TIC80_WIDTH);
+
+            blitRow(rowPtr, row0 + offsetX0, row1 + offsetX1, bank1->vars.clear, &pal);
         }
 
-        rowPtr += TIC80_MARGIN_RIGHT;
+        rowPtr += TIC80_WIDTH + TIC80_MARGIN_RIGHT;
     }
 
     for(; row != TIC80_FULLHEIGHT; ++row, rowPtr += TIC80_FULLWIDTH)
-        UPDBDR();
+        memset4(rowPtr, UPDBDR(), TIC80_FULLWIDTH);
 
 #undef  UPDBDR
+
+    tic_core_profile_stage(tic, tic_profile_blit);
 }
 
 static inline void scanline(tic_mem* memory, s32 row, void* data)
 {
     tic_core* core = (tic_core*)memory;
 
-    if (core->state.initialized)
+    if (core->state.initialized && !tic_core_budget_over(core))
+    {
+        tic_core_profile_begin(memory);
         core->state.callback.scanline(memory, row, data);
+        endProfileStage(core, tic_profile_scn, row);
+    }
 }
 
 static inline void border(tic_mem* memory, s32 row, void* data)
 {
     tic_core* core = (tic_core*)memory;
 
-    if (core->state.initialized)
+    if (core->state.initialized && !tic_core_budget_over(core))
+    {
+        tic_core_profile_begin(memory);
         core->state.callback.border(memory, row, data);
+        endProfileStage(core, tic_profile_bdr, row);
+    }
 }
 
 void tic_core_blit(tic_mem* tic)
 {
+    tic_core* core = (tic_core*)tic;
+
     tic_core_blit_ex(tic, (tic_blit_callback){scanline, border, NULL});
+    endBudget(core);
 }
 
-tic_mem* tic_core_create(s32 samplerate, tic80_pixel_color_format format)
+tic_mem* tic_core_create(s32 samplerate, tic80_pixel_color_format format, tic80_latency latency)
 {
     tic_core* core = (tic_core*)malloc(sizeof(tic_core));
     memset(core, 0, sizeof(tic_core));
@@ -757,8 +1388,11 @@ tic_mem* tic_core_create(s32 samplerate, tic80_pixel_color_format format)
     product->samples.count = samplerate * TIC80_SAMPLE_CHANNELS / TIC80_FRAMERATE;
     product->samples.buffer = malloc(product->samples.count * TIC80_SAMPLESIZE);
 
-    core->blip.left = blip_new(samplerate / 10);
-    core->blip.right = blip_new(samplerate / 10);
+    // blips are read out every frame, low latency only keeps room for a few
+    s32 blipsize = latency == TIC80_LATENCY_LOW ? samplerate / 20 : samplerate / 10;
+    core->blip.left = blip_new(blipsize);
+    core->blip.right = blip_new(blipsize);
+    core->sound.ringlen = latency == TIC80_LATENCY_LOW ? TIC_SOUND_RINGBUF_LOW_LEN : TIC_SOUND_RINGBUF_LEN;
 
     blip_set_rates(core->blip.left, CLOCKRATE, samplerate);
     blip_set_rates(core->blip.right, CLOCKRATE, samplerate);
@@ -25,10 +25,12 @@
 #include "api.h"
 #include "tools.h"
 #include "blip_buf.h"
+#include "ext/rewind.h"
 
 #define CLOCKRATE (255<<13)
 #define TIC_DEFAULT_COLOR 15
 #define TIC_SOUND_RINGBUF_LEN 12 // in worst case, this induces ~ 12 tick delay i.e. 200 ms
+#define TIC_SOUND_RINGBUF_LOW_LEN 4 // ~ 3 tick delay for the low latency mode
 
 typedef struct
 {
@@ -126,6 +128,8 @@ typedef struct
         tic_stereo_volume stereo;
     } sound_ringbuf[TIC_SOUND_RINGBUF_LEN];
 
+    // the tick owns the head and the synth owns the tail, they can run on
+    // separate threads and see each other's index through tic_atomic.h
     u32 sound_ringbuf_head;
     u32 sound_ringbuf_tail;
 
@@ -164,12 +168,107 @@ typedef struct
     bool initialized;
 } tic_core_state_data;
 
+// tiles, sprites and font expanded to one byte per pixel for every bpp mode,
+// a block is expanded again only when its source bytes differ from the copy
+// it was expanded from, so writes through any path (poke, memcpy, sync,
+// editors or WASM linear memory) are picked up lazily on the next draw
+typedef struct
+{
+    struct
+    {
+        bool valid[TIC_SPRITES];
+        u8 src[TIC_SPRITES][sizeof(tic_tile)];
+        u8 bpp4[TIC_SPRITES][sizeof(tic_tile) * BITS_IN_BYTE / tic_bpp_4];
+        u8 bpp2[TIC_SPRITES][sizeof(tic_tile) * BITS_IN_BYTE / tic_bpp_2];
+        u8 bpp1[TIC_SPRITES][sizeof(tic_tile) * BITS_IN_BYTE / tic_bpp_1];
+    } tiles;
+
+    struct
+    {
+        bool valid[TIC_SPRITES];
+        u8 src[TIC_SPRITES][TIC_SPRITESIZE];
+        u8 bpp1[TIC_SPRITES][TIC_SPRITESIZE * BITS_IN_BYTE];
+    } font;
+} tic_tilecache;
+
+// per instance scratch state of the rasterizer, nothing in draw.c is shared
+// between cores, so separate instances can draw on separate threads
+typedef struct
+{
+    u8 mapping[TIC_PALETTE_SIZE];
+    double zbuffer[TIC80_WIDTH * TIC80_HEIGHT];
+
+    struct
+    {
+        s16 left[TIC80_HEIGHT];
+        s16 right[TIC80_HEIGHT];
+    } sides;
+} tic_rasterstate;
+
+// the API calls nest only through map remap and script callbacks
+#define TIC_PROFILE_DEPTH 8
+
+typedef struct
+{
+    bool enabled;
+    s32 depth;
+    u64 start[TIC_PROFILE_DEPTH];
+    tic_profile_frame frame;
+    tic_profile_data data;
+    Tracing* tracing;
+} tic_profiler;
+
+// first tick of every row for the playing tempo, speed and track length,
+// it's derived from the state and rebuilt whenever one of them changes
+typedef struct
+{
+    s32 count;
+    s32 tempo;
+    s32 speed;
+    s32 row;
+    s32 ticks[MUSIC_PATTERN_ROWS + 1];
+} tic_music_timeline;
+
+// derived script data like transpiled code or bytecode, keyed by its kind
+// and a hash of the source, it lives across resets and the host can keep
+// it across runs with the cache callbacks of tic_tick_data
+#define TIC_SCRIPT_CACHE_ITEMS 4
+
+typedef struct
+{
+    struct
+    {
+        char key[64];
+        void* data;
+        s32 size;
+        u32 used;
+    } items[TIC_SCRIPT_CACHE_ITEMS];
+
+    u32 clock;
+} tic_script_cache;
+
+// the script time of the current frame against the tic_tick_data budget,
+// the deadline is in counter units and it's 0 when there is no limit
+#define TIC_BUDGET_REPORT_SIZE 64
+
+typedef struct
+{
+    u64 start;
+    u64 deadline;
+    // for the VMs that only look at the clock every so many hook calls
+    u32 count;
+    bool over;
+    bool reported;
+    char report[TIC_BUDGET_REPORT_SIZE];
+} tic_script_budget;
+
 typedef struct
 {
     tic_mem memory; // it should be first
     tic80_pixel_color_format screen_format;
 
     void* currentVM;
+    void* spareVM;
     const tic_script_config* currentScript;
 
     struct
@@ -179,8 +278,40 @@ typedef struct
     } blip;
     
     s32 samplerate;
+    tic_synth synth;
+
+    struct
+    {
+        // ring length in use, up to TIC_SOUND_RINGBUF_LEN
+        u32 ringlen;
+        tic80_sound_stats stats;
+
+        // every channel also goes to its own blips while the buses are on
+        struct
+        {
+            blip_buffer_t* left[TIC_SOUND_CHANNELS];
+            blip_buffer_t* right[TIC_SOUND_CHANNELS];
+            s16* samples;
+        } bus;
+    } sound;
+
     tic_tick_data* data;
     tic_core_state_data state;
+    tic_tilecache tilecache;
+    tic_rasterstate raster;
+
+    struct
+    {
+        Rewind* history;
+        u8* state;
+        u32 budget;
+    } rewind;
+
+    tic_profiler profiler;
+    tic_music_timeline timeline;
+    tic_script_cache cache;
+    tic_script_init init;
+    tic_script_budget budget;
 
     struct
     {
@@ -198,8 +329,20 @@ typedef struct
 } tic_core;
 
 void tic_core_tick_io(tic_mem* memory);
-void tic_core_sound_tick_start(tic_mem* memory);
-void tic_core_sound_tick_end(tic_mem* memory);
+void tic_core_profile_begin(tic_mem* memory);
+void tic_core_profile_end(tic_mem* memory, s32 index);
+void tic_core_profile_stage(tic_mem* memory, tic_profile_stage stage);
+
+// the loaded data stays valid until the next save
+const void* tic_core_cache_load(tic_core* core, const char* kind, const void* src, s32 srcSize, s32* size);
+void tic_core_cache_save(tic_core* core, const char* kind, const void* src, s32 srcSize, const void* data, s32 size);
+
+// the VMs arm it once the cart is compiled, right before its body runs
+void tic_core_budget_arm(tic_core* core);
+
+// the VM hooks poll it to stop the running code, the report is the error text
+bool tic_core_budget_over(tic_core* core);
+const char* tic_core_budget_report(tic_core* core);
 
 #if defined(BUILD_DEPRECATED)
 // mouse cursor is the same in both modes
@@ -29,6 +29,8 @@
 #include <math.h>
 #include <float.h>
 
+#include "tic_assert.h"
+
 #define TRANSPARENT_COLOR 255
 
 typedef void(*PixelFunc)(tic_mem* memory, s32 x, s32 y, u8 color);
@@ -47,9 +49,93 @@ static tic_tilesheet getTileSheetFromSegment(tic_mem* memory, u8 segment)
     return tic_tilesheet_get(segment, src);
 }
 
+enum { FontBlockShift = 3, TileBlockShift = 5 };
+
+static_assert(1 << FontBlockShift == TIC_SPRITESIZE, "font_block_shift");
+static_assert(1 << TileBlockShift == sizeof(tic_tile), "tile_block_shift");
+
+typedef struct
+{
+    bool font;
+    const u8* base;
+    const u8* pixels;
+    s32 size;
+    s32 shift;
+} TileCache;
+
+static TileCache getTileCache(tic_core* core, const tic_blit_segment* segment)
+{
+    tic_tilecache* cache = &core->tilecache;
+    const u8* tiles = (const u8*)core->memory.ram->tiles.data;
+
+    if (segment->ptr_size == TIC_SPRITESIZE)
+        return (TileCache){true, (const u8*)&core->memory.ram->font, cache->font.bpp1[0], sizeof cache->font.bpp1[0], FontBlockShift};
+
+    switch (segment->tile_width)
+    {
+    case TIC_SPRITESIZE * 2: return (TileCache){false, tiles, cache->tiles.bpp2[0], sizeof cache->tiles.bpp2[0], TileBlockShift};
+    case TIC_SPRITESIZE * 4: return (TileCache){false, tiles, cache->tiles.bpp1[0], sizeof cache->tiles.bpp1[0], TileBlockShift};
+    default: return (TileCache){false, tiles, cache->tiles.bpp4[0], sizeof cache->tiles.bpp4[0], TileBlockShift};
+    }
+}
+
+static void updateTileCache(tic_core* core, const TileCache* cache, s32 index)
+{
+    tic_tilecache* tc = &core->tilecache;
+
+    if (cache->font)
+    {
+        const u8* src = cache->base + index * sizeof tc->font.src[0];
+
+        if (tc->font.valid[index] && memcmp(tc->font.src[index], src, sizeof tc->font.src[0]) == 0)
+            return;
+
+        memcpy(tc->font.src[index], src, sizeof tc->font.src[0]);
+
+        for (s32 i = 0; i < sizeof tc->font.bpp1[0]; i++)
+            tc->font.bpp1[index][i] = tic_tool_peek1(src, i);
+
+        tc->font.valid[index] = true;
+    }
+    else
+    {
+        const u8* src = cache->base + index * sizeof tc->tiles.src[0];
+
+        if (tc->tiles.valid[index] && memcmp(tc->tiles.src[index], src, sizeof tc->tiles.src[0]) == 0)
+            return;
+
+        memcpy(tc->tiles.src[index], src, sizeof tc->tiles.src[0]);
+
+        for (s32 i = 0; i < sizeof tc->tiles.bpp4[0]; i++)
+            tc->tiles.bpp4[index][i] = tic_tool_peek4(src, i);
+
+        for (s32 i = 0; i < sizeof tc->tiles.bpp2[0]; i++)
+            tc->tiles.bpp2[index][i] = tic_tool_peek2(src, i);
+
+        for (s32 i = 0; i < sizeof tc->tiles.bpp1[0]; i++)
+            tc->tiles.bpp1[index][i] = tic_tool_peek1(src, i);
+
+        tc->tiles.valid[index] = true;
+    }
+}
+
+static void updateTileCacheRange(tic_core* core, const TileCache* cache, s32 from, s32 count)
+{
+    for (s32 i = from; i < from + count; i++)
+        updateTileCache(core, cache, i);
+}
+
+// returns expanded tile pixels, pixel(x, y) is at [x + y * tile_width]
+static inline const u8* getTilePixels(tic_core* core, const TileCache* cache, const tic_tileptr* tile)
+{
+    s32 index = (s32)(tile->ptr - cache->base) >> cache->shift;
+    updateTileCache(core, cache, index);
+    return cache->pixels + index * cache->size + tile->offset;
+}
+
 static u8* getPalette(tic_mem* tic, u8* colors, u8 count)
 {
-    static u8 mapping[TIC_PALETTE_SIZE];
+    u8* mapping = ((tic_core*)tic)->raster.mapping;
     for (s32 i = 0; i < TIC_PALETTE_SIZE; i++) mapping[i] = tic_tool_peek4(tic->ram->vram.mapping, i);
     for (s32 i = 0; i < count; i++) mapping[colors[i]] = TRANSPARENT_COLOR;
     return mapping;
@@ -72,7 +158,7 @@ static inline void setPixel(tic_core* core, s32 x, s32 y, u8 color)
 static inline void setPixelFast(tic_core* core, s32 x, s32 y, u8 color)
 {
     // does not do any CLIP checking, the caller needs to do that first
-    tic_api_poke4((tic_mem*)core, y * TIC80_WIDTH + x, color);
+    tic_tool_poke4(core->memory.ram->vram.screen.data, y * TIC80_WIDTH + x, color);
 }
 
 static u8 getPixel(tic_core* core, s32 x, s32 y)
@@ -90,18 +176,34 @@ static u8 getPixel(tic_core* core, s32 x, s32 y)
         || ((x) >= core->state.clip.r) \
     )
 
-static void drawHLine(tic_core* core, s32 x, s32 y, s32 width, u8 color)
+// fills [start, end) screen pixels, the unaligned edge nibbles are poked
+// separately and the byte aligned middle part is filled with memset
+static inline void fillSpan(tic_core* core, s32 start, s32 end, u8 color)
 {
-    const tic_vram* vram = &core->memory.ram->vram;
+    if (start >= end) return;
+
+    u8* screen = core->memory.ram->vram.screen.data;
+    color &= 0xf;
+
+    if (start & 1)
+        tic_tool_poke4(screen, start++, color);
+
+    if (end & 1)
+        tic_tool_poke4(screen, --end, color);
 
+    if (start < end)
+        memset(screen + (start >> 1), color | (color << TIC_PALETTE_BPP), (end - start) >> 1);
+}
+
+static void drawHLine(tic_core* core, s32 x, s32 y, s32 width, u8 color)
+{
     if (y < core->state.clip.t || core->state.clip.b <= y) return;
 
     s32 xl = MAX(x, core->state.clip.l);
     s32 xr = MIN(x + width, core->state.clip.r);
     s32 start = y * TIC80_WIDTH;
 
-    for(s32 i = start + xl, end = start + xr; i < end; ++i)
-        tic_api_poke4((tic_mem*)core, i, color);
+    fillSpan(core, start + xl, start + xr, color);
 }
 
 static void drawVLine(tic_core* core, s32 x, s32 y, s32 height, u8 color)
@@ -119,8 +221,15 @@ static void drawVLine(tic_core* core, s32 x, s32 y, s32 height, u8 color)
 
 static void drawRect(tic_core* core, s32 x, s32 y, s32 width, s32 height, u8 color)
 {
-    for (s32 i = y; i < y + height; ++i)
-        drawHLine(core, x, i, width, color);
+    s32 xl = MAX(x, core->state.clip.l);
+    s32 xr = MIN(x + width, core->state.clip.r);
+    s32 yt = MAX(y, core->state.clip.t);
+    s32 yb = MIN(y + height, core->state.clip.b);
+
+    if (xl >= xr) return;
+
+    for (s32 i = yt, start = yt * TIC80_WIDTH; i < yb; ++i, start += TIC80_WIDTH)
+        fillSpan(core, start + xl, start + xr, color);
 }
 
 static void drawRectBorder(tic_core* core, s32 x, s32 y, s32 width, s32 height, u8 color)
@@ -138,7 +247,7 @@ static void drawRectBorder(tic_core* core, s32 x, s32 y, s32 width, s32 height,
         s32 xx = x; \
         for(s32 px=sx; px < ex; px++, xx++) \
         { \
-            u8 color = mapping[tic_tilesheet_gettilepix(tile, (X), (Y))];\
+            u8 color = mapping[pixels[(X) + (Y) * width]];\
             if(color != TRANSPARENT_COLOR) setPixelFast(core, xx, y, color); \
         } \
     } \
@@ -148,8 +257,10 @@ static void drawRectBorder(tic_core* core, s32 x, s32 y, s32 width, s32 height,
 
 static void drawTile(tic_core* core, tic_tileptr* tile, s32 x, s32 y, u8* colors, s32 count, s32 scale, tic_flip flip, tic_rotate rotate)
 {
-    const tic_vram* vram = &core->memory.ram->vram;
     u8* mapping = getPalette(&core->memory, colors, count);
+    TileCache cache = getTileCache(core, tile->segment);
+    const u8* pixels = getTilePixels(core, &cache, tile);
+    s32 width = tile->segment->tile_width;
 
     rotate &= 3;
     u32 orientation = flip & 3;
@@ -193,7 +304,7 @@ static void drawTile(tic_core* core, tic_tileptr* tile, s32 x, s32 y, u8* colors
             if (orientation & 4) {
                 s32 tmp = ix; ix = iy; iy = tmp;
             }
-            u8 color = mapping[tic_tilesheet_gettilepix(tile, ix, iy)];
+            u8 color = mapping[pixels[ix + iy * width]];
             if (color != TRANSPARENT_COLOR) drawRect(core, xx, y, scale, scale, color);
         }
     }
@@ -295,21 +406,23 @@ static void drawMap(tic_core* core, const tic_map* src, s32 x, s32 y, s32 width,
 
 static s32 drawChar(tic_core* core, tic_tileptr* font_char, s32 x, s32 y, s32 scale, bool fixed, u8* mapping)
 {
-    const tic_vram* vram = &core->memory.ram->vram;
-
     enum { Size = TIC_SPRITESIZE };
 
+    TileCache cache = getTileCache(core, font_char->segment);
+    const u8* pixels = getTilePixels(core, &cache, font_char);
+    s32 stride = font_char->segment->tile_width;
+
     s32 j = 0, start = 0, end = Size;
 
     if (!fixed) {
         for (s32 i = 0; i < Size; i++) {
             for (j = 0; j < Size; j++)
-                if (mapping[tic_tilesheet_gettilepix(font_char, i, j)] != TRANSPARENT_COLOR) break;
+                if (mapping[pixels[i + j * stride]] != TRANSPARENT_COLOR) break;
             if (j < Size) break; else start++;
         }
         for (s32 i = Size - 1; i >= start; i--) {
             for (j = 0; j < Size; j++)
-                if (mapping[tic_tilesheet_gettilepix(font_char, i, j)] != TRANSPARENT_COLOR) break;
+                if (mapping[pixels[i + j * stride]] != TRANSPARENT_COLOR) break;
             if (j < Size) break; else end--;
         }
     }
@@ -323,7 +436,7 @@ static s32 drawChar(tic_core* core, tic_tileptr* font_char, s32 x, s32 y, s32 sc
     {
         for (s32 j = 0, row = rowStart, ys = y; j < Size; j++, row += rowStep, ys += scale)
         {
-            u8 color = tic_tilesheet_gettilepix(font_char, col, row);
+            u8 color = pixels[col + row * stride];
             if (mapping[color] != TRANSPARENT_COLOR)
                 drawRect(core, xs, ys, scale, scale, mapping[color]);
         }
@@ -380,8 +493,6 @@ void tic_api_rect(tic_mem* memory, s32 x, s32 y, s32 width, s32 height, u8 color
     drawRect(core, x, y, width, height, mapColor(memory, color));
 }
 
-static double ZBuffer[TIC80_WIDTH * TIC80_HEIGHT];
-
 void tic_api_cls(tic_mem* tic, u8 color)
 {
     tic_core* core = (tic_core*)tic;
@@ -394,15 +505,17 @@ void tic_api_cls(tic_mem* tic, u8 color)
     if (MEMCMP(core->state.clip, EmptyClip))
     {
         memset(&vram->screen, (color & 0xf) | (color << TIC_PALETTE_BPP), sizeof(tic_screen));
-        ZEROMEM(ZBuffer);
+        ZEROMEM(core->raster.zbuffer);
     }
     else
     {
-        for(s32 y = core->state.clip.t, start = y * TIC80_WIDTH; y < core->state.clip.b; ++y, start += TIC80_WIDTH)
-            for(s32 x = core->state.clip.l, pixel = start + x; x < core->state.clip.r; ++x, ++pixel)
+        s32 l = core->state.clip.l, r = core->state.clip.r;
+
+        if (l < r)
+            for(s32 y = core->state.clip.t, start = y * TIC80_WIDTH; y < core->state.clip.b; ++y, start += TIC80_WIDTH)
             {
-                tic_api_poke4(tic, pixel, color);
-                ZBuffer[pixel] = 0;
+                fillSpan(core, start + l, start + r, color);
+                memset(core->raster.zbuffer + start + l, 0, (r - l) * sizeof core->raster.zbuffer[0]);
             }
     }
 }
@@ -438,26 +551,25 @@ void tic_api_spr(tic_mem* memory, s32 index, s32 x, s32 y, s32 w, s32 h, u8* tra
     drawSprite((tic_core*)memory, index, x, y, w, h, trans_colors, trans_count, scale, flip, rotate);
 }
 
-static inline u8* getFlag(tic_mem* memory, s32 index, u8 flag)
+static inline bool validFlag(s32 index, u8 flag)
 {
-    static u8 stub = 0;
-    if (index >= TIC_FLAGS || flag >= BITS_IN_BYTE)
-        return &stub;
-
-    return memory->ram->flags.data + index;
+    return index >= 0 && index < TIC_FLAGS && flag < BITS_IN_BYTE;
 }
 
 bool tic_api_fget(tic_mem* memory, s32 index, u8 flag)
 {
-    return *getFlag(memory, index, flag) & (1 << flag);
+    return validFlag(index, flag) && (memory->ram->flags.data[index] & (1 << flag));
 }
 
 void tic_api_fset(tic_mem* memory, s32 index, u8 flag, bool value)
 {
+    if (!validFlag(index, flag))
+        return;
+
     if (value)
-        *getFlag(memory, index, flag) |= (1 << flag);
+        memory->ram->flags.data[index] |= (1 << flag);
     else
-        *getFlag(memory, index, flag) &= ~(1 << flag);
+        memory->ram->flags.data[index] &= ~(1 << flag);
 }
 
 u8 tic_api_pix(tic_mem* memory, s32 x, s32 y, u8 color, bool get)
@@ -477,24 +589,18 @@ void tic_api_rectb(tic_mem* memory, s32 x, s32 y, s32 width, s32 height, u8 colo
     drawRectBorder(core, x, y, width, height, mapColor(memory, color));
 }
 
-static struct
-{
-    s16 Left[TIC80_HEIGHT];
-    s16 Right[TIC80_HEIGHT];
-} SidesBuffer;
-
-static void initSidesBuffer()
+static void initSidesBuffer(tic_core* core)
 {
-    for (s32 i = 0; i < COUNT_OF(SidesBuffer.Left); i++)
-        SidesBuffer.Left[i] = TIC80_WIDTH, SidesBuffer.Right[i] = -1;
+    for (s32 i = 0; i < COUNT_OF(core->raster.sides.left); i++)
+        core->raster.sides.left[i] = TIC80_WIDTH, core->raster.sides.right[i] = -1;
 }
 
-static void setSidePixel(s32 x, s32 y)
+static void setSidePixel(tic_core* core, s32 x, s32 y)
 {
     if (y >= 0 && y < TIC80_HEIGHT)
     {
-        if (x < SidesBuffer.Left[y]) SidesBuffer.Left[y] = x;
-        if (x > SidesBuffer.Right[y]) SidesBuffer.Right[y] = x;
+        if (x < core->raster.sides.left[y]) core->raster.sides.left[y] = x;
+        if (x > core->raster.sides.right[y]) core->raster.sides.right[y] = x;
     }
 }
 
@@ -539,31 +645,27 @@ static void setElliPixel(tic_mem* tic, s32 x, s32 y, u8 color)
 
 static void setElliSide(tic_mem* tic, s32 x, s32 y, u8 color)
 {
-    setSidePixel(x, y);
+    setSidePixel((tic_core*)tic, x, y);
 }
 
 static void drawSidesBuffer(tic_mem* memory, s32 y0, s32 y1, u8 color)
 {
-    tic_vram* vram = &memory->ram->vram;
-
     tic_core* core = (tic_core*)memory;
     s32 yt = MAX(core->state.clip.t, y0);
     s32 yb = MIN(core->state.clip.b, y1 + 1);
-    u8 final_color = mapColor(&core->memory, color);
     for (s32 y = yt; y < yb; y++) 
     {
-        s32 xl = MAX(SidesBuffer.Left[y], core->state.clip.l);
-        s32 xr = MIN(SidesBuffer.Right[y] + 1, core->state.clip.r);
+        s32 xl = MAX(core->raster.sides.left[y], core->state.clip.l);
+        s32 xr = MIN(core->raster.sides.right[y] + 1, core->state.clip.r);
         s32 start = y * TIC80_WIDTH;
 
-        for(s32 i = start + xl, end = start + xr; i < end; ++i)
-            tic_api_poke4(memory, i, color);
+        fillSpan(core, start + xl, start + xr, color);
     }
 }
 
 void tic_api_circ(tic_mem* memory, s32 x, s32 y, s32 r, u8 color)
 {
-    initSidesBuffer();
+    initSidesBuffer((tic_core*)memory);
     drawEllipse(memory, x - r, y - r, x + r, y + r, 0, setElliSide);
     drawSidesBuffer(memory, y - r, y + r + 1, mapColor(memory, color));
 }
@@ -575,7 +677,7 @@ void tic_api_circb(tic_mem* memory, s32 x, s32 y, s32 r, u8 color)
 
 void tic_api_elli(tic_mem* memory, s32 x, s32 y, s32 a, s32 b, u8 color)
 {
-    initSidesBuffer();
+    initSidesBuffer((tic_core*)memory);
     drawEllipse(memory, x - a, y - b, x + a, y + b, 0, setElliSide);
     drawSidesBuffer(memory, y - b, y + b + 1, mapColor(memory, color));
 }
@@ -641,86 +743,184 @@ typedef struct
 } ShaderAttr;
 
 typedef tic_color(*PixelShader)(const ShaderAttr* a, s32 pixel);
+typedef void(*SpanShader)(tic_core* core, ShaderAttr* a, s32 pixel, s32 count, const Vec3* dw);
 
 static inline double edgeFn(const Vec2* a, const Vec2* b, const Vec2* c)
 {
     return (b->x - a->x) * (c->y - a->y) - (b->y - a->y) * (c->x - a->x);
 }
 
-static void drawTri(tic_mem* tic, const Vec2* v0, const Vec2* v1, const Vec2* v2, PixelShader shader, void* data)
+enum
+{
+    TriSubBits = 8,             // sub-pixel precision of the vertices
+    TriMaxCoord = 1 << 29,      // keeps the 64 bit edge functions from overflowing
+    TriBlockSize = 8,
+};
+
+typedef struct
+{
+    s64 value;  // edge function at the bounding box origin pixel center
+    s64 dx, dy; // steps per pixel
+    s64 bias;   // 1 for the edges which don't own the samples lying exactly on them
+} TriEdge;
+
+static void drawTri(tic_mem* tic, const Vec2* v0, const Vec2* v1, const Vec2* v2, SpanShader shader, void* data)
 {
     ShaderAttr a = {data, v0, v1, v2};
 
     tic_core* core = (tic_core*)tic;
     const struct ClipRect* clip = &core->state.clip;
 
-    tic_point min = {floor(MIN3(a.v[0]->x, a.v[1]->x, a.v[2]->x)), floor(MIN3(a.v[0]->y, a.v[1]->y, a.v[2]->y))};
-    tic_point max = {ceil(MAX3(a.v[0]->x, a.v[1]->x, a.v[2]->x)), ceil(MAX3(a.v[0]->y, a.v[1]->y, a.v[2]->y))};
+    tic_point min = 
+    {
+        MAX(floor(MIN3(a.v[0]->x, a.v[1]->x, a.v[2]->x)), clip->l), 
+        MAX(floor(MIN3(a.v[0]->y, a.v[1]->y, a.v[2]->y)), clip->t)
+    };
 
-    min.x = MAX(min.x, clip->l);
-    min.y = MAX(min.y, clip->t);
-    max.x = MIN(max.x, clip->r);
-    max.y = MIN(max.y, clip->b);
+    tic_point max = 
+    {
+        MIN(ceil(MAX3(a.v[0]->x, a.v[1]->x, a.v[2]->x)), clip->r), 
+        MIN(ceil(MAX3(a.v[0]->y, a.v[1]->y, a.v[2]->y)), clip->b)
+    };
 
     if(min.x >= max.x || min.y >= max.y) return;
 
     double area = edgeFn(a.v[0], a.v[1], a.v[2]);
-    if((s32)floor(area) == 0) return;
+    if(isnan(area) || (s32)floor(area) == 0) return;
     if(area < 0.0)
-    {
         SWAP(a.v[1], a.v[2], const Vec2*);
-        area = -area;
-    }
 
-    Vec2 d[3];
-    Vec3 s;
+    // snap vertices to fixed point, the precision is reduced for huge triangles
+    double range = 0;
+    for(s32 i = 0; i != COUNT_OF(a.v); ++i)
+        range = MAX3(range, fabs(a.v[i]->x), fabs(a.v[i]->y));
+
+    s32 bits = TriSubBits;
+    while(bits > 1 && range * (1 << bits) > TriMaxCoord) bits--;
 
-    for(s32 i = 0; i != COUNT_OF(s.d); ++i)
+    s64 vx[3], vy[3];
+    for(s32 i = 0; i != COUNT_OF(a.v); ++i)
     {
-        // pixel center
-        const double Center = 0.5 - FLT_EPSILON;
-        Vec2 p = {min.x + Center, min.y + Center};
+        vx[i] = (s64)floor(CLAMP(a.v[i]->x * (1 << bits), -TriMaxCoord, TriMaxCoord) + 0.5);
+        vy[i] = (s64)floor(CLAMP(a.v[i]->y * (1 << bits), -TriMaxCoord, TriMaxCoord) + 0.5);
+    }
+
+    s64 fixedArea = (vx[1] - vx[0]) * (vy[2] - vy[0]) - (vy[1] - vy[0]) * (vx[2] - vx[0]);
+    if(fixedArea <= 0) return;
 
+    // pixel center of the bounding box origin
+    s64 px = ((s64)min.x << bits) + (1 << (bits - 1));
+    s64 py = ((s64)min.y << bits) + (1 << (bits - 1));
+
+    TriEdge edges[3];
+    for(s32 i = 0; i != COUNT_OF(edges); ++i)
+    {
         s32 c = (i + 1) % 3, n = (i + 2) % 3;
-        
-        d[i].x = (a.v[c]->y - a.v[n]->y) / area;
-        d[i].y = (a.v[n]->x - a.v[c]->x) / area;
-        s.d[i] = edgeFn(a.v[c], a.v[n], &p) / area;
+        TriEdge* e = &edges[i];
+
+        e->value = (vx[n] - vx[c]) * (py - vy[c]) - (vy[n] - vy[c]) * (px - vx[c]);
+        e->dx = (vy[c] - vy[n]) * ((s64)1 << bits);
+        e->dy = (vx[n] - vx[c]) * ((s64)1 << bits);
+
+        // samples on an edge are taken as if moved by a tiny step to the top-left,
+        // it is the same tie breaking the floating point rasterizer had
+        e->bias = e->dx + e->dy > 0;
     }
 
-    for(s32 y = min.y, start = min.y * TIC80_WIDTH + min.x; y < max.y; ++y, start += TIC80_WIDTH)
+    const double invArea = 1.0 / fixedArea;
+    Vec3 dw;
+    for(s32 i = 0; i != COUNT_OF(edges); ++i)
+        dw.d[i] = edges[i].dx * invArea;
+
+    for(s32 by = min.y; by < max.y; by += TriBlockSize)
     {
-        for(s32 i = 0; i != COUNT_OF(a.w.d); ++i)
-            a.w.d[i] = s.d[i];
+        s32 bh = MIN(TriBlockSize, max.y - by);
+        s32 first[TriBlockSize], last[TriBlockSize];
+
+        for(s32 r = 0; r != bh; ++r)
+            first[r] = max.x, last[r] = min.x;
 
-        for(s32 x = min.x, pixel = start; x < max.x; ++x, ++pixel)
+        for(s32 bx = min.x; bx < max.x; bx += TriBlockSize)
         {
-            if(a.w.x > -DBL_EPSILON && a.w.y > -DBL_EPSILON && a.w.z > -DBL_EPSILON)
+            s32 bw = MIN(TriBlockSize, max.x - bx);
+            s64 e[3];
+            bool inside = true, outside = false;
+
+            // test the block corners against every edge
+            for(s32 i = 0; i != COUNT_OF(edges) && !outside; ++i)
             {
-                u8 color = shader(&a, pixel);
-                if(color != TRANSPARENT_COLOR)
-                    tic_api_poke4(tic, pixel, color);
+                const TriEdge* edge = &edges[i];
+                e[i] = edge->value + (bx - min.x) * edge->dx + (by - min.y) * edge->dy - edge->bias;
+
+                s64 c00 = e[i], c10 = c00 + edge->dx * (bw - 1);
+                s64 c01 = c00 + edge->dy * (bh - 1), c11 = c10 + edge->dy * (bh - 1);
+
+                if(c00 < 0 && c10 < 0 && c01 < 0 && c11 < 0) outside = true;
+                else if(c00 < 0 || c10 < 0 || c01 < 0 || c11 < 0) inside = false;
             }
 
-            for(s32 i = 0; i != COUNT_OF(a.w.d); ++i)
-                a.w.d[i] += d[i].x;
+            if(outside) continue;
+
+            if(inside)
+            {
+                for(s32 r = 0; r != bh; ++r)
+                    first[r] = MIN(first[r], bx), last[r] = MAX(last[r], bx + bw);
+                continue;
+            }
+
+            for(s32 r = 0; r != bh; ++r)
+            {
+                s64 e0 = e[0] + r * edges[0].dy, e1 = e[1] + r * edges[1].dy, e2 = e[2] + r * edges[2].dy;
+
+                for(s32 c = 0; c != bw; ++c, e0 += edges[0].dx, e1 += edges[1].dx, e2 += edges[2].dx)
+                    if((e0 | e1 | e2) >= 0)
+                        first[r] = MIN(first[r], bx + c), last[r] = MAX(last[r], bx + c + 1);
+            }
         }
 
-        for(s32 i = 0; i != COUNT_OF(s.d); ++i)
-            s.d[i] += d[i].y;
+        // the covered samples of a row are contiguous, so every row is a single span
+        for(s32 r = 0, y = by; r != bh; ++r, ++y)
+        {
+            if(first[r] >= last[r]) continue;
+
+            s32 pixel = y * TIC80_WIDTH + first[r];
+
+            if(shader)
+            {
+                for(s32 i = 0; i != COUNT_OF(edges); ++i)
+                    a.w.d[i] = (edges[i].value + (first[r] - min.x) * edges[i].dx + (y - min.y) * edges[i].dy) * invArea;
+
+                shader(core, &a, pixel, last[r] - first[r], &dw);
+            }
+            else fillSpan(core, pixel, pixel + last[r] - first[r], *(u8*)data);
+        }
     }
 }
 
-static tic_color triColorShader(const ShaderAttr* a, s32 pixel){return *(u8*)a->data;}
+static inline void shadeSpan(tic_core* core, ShaderAttr* a, s32 pixel, s32 count, const Vec3* dw, PixelShader shader)
+{
+    u8* screen = core->memory.ram->vram.screen.data;
+
+    for(s32 end = pixel + count; pixel != end; ++pixel)
+    {
+        u8 color = shader(a, pixel);
+        if(color != TRANSPARENT_COLOR)
+            tic_tool_poke4(screen, pixel, color);
+
+        for(s32 i = 0; i != COUNT_OF(a->w.d); ++i)
+            a->w.d[i] += dw->d[i];
+    }
+}
 
 void tic_api_tri(tic_mem* tic, float x1, float y1, float x2, float y2, float x3, float y3, u8 color)
 {
+    // NULL shader means solid color fill
     color = mapColor(tic, color);
     drawTri(tic,
         &(Vec2){x1, y1},
         &(Vec2){x2, y2},
         &(Vec2){x3, y3}, 
-        triColorShader, &color);
+        NULL, &color);
 }
 
 void tic_api_trib(tic_mem* tic, float x1, float y1, float x2, float y2, float x3, float y3, u8 color)
@@ -743,9 +943,11 @@ typedef struct
 typedef struct
 {
     tic_tilesheet sheet;
+    TileCache cache;
     u8* mapping;
     const u8* map;
     const tic_vram* vram;
+    double* zbuffer;
     bool depth;
 } TexData;
 
@@ -762,7 +964,7 @@ static inline bool shaderStart(const ShaderAttr* a, Vec3* vars, s32 pixel)
             vars->z += a->w.d[i] * t->d.z;
         }
 
-        if(ZBuffer[pixel] < vars->z);
+        if(data->zbuffer[pixel] < vars->z);
         else return false;
     }
 
@@ -786,7 +988,7 @@ static inline tic_color shaderEnd(const ShaderAttr* a, const Vec3* vars, s32 pix
     TexData* data = a->data;
 
     if(data->depth && color != TRANSPARENT_COLOR)
-        ZBuffer[pixel] = vars->z;
+        data->zbuffer[pixel] = vars->z;
 
     return color;
 }
@@ -808,7 +1010,10 @@ static tic_color triTexMapShader(const ShaderAttr* a, s32 pixel)
     u8 idx = data->map[(iv >> 3) * TIC_MAP_WIDTH + (iu >> 3)];
     tic_tileptr tile = tic_tilesheet_gettile(&data->sheet, idx, true);
 
-    return shaderEnd(a, &vars, pixel, data->mapping[tic_tilesheet_gettilepix(&tile, iu & WMask, iv & HMask)]);
+    s32 index = (s32)(tile.ptr - data->cache.base) >> data->cache.shift;
+    const u8* pixels = data->cache.pixels + index * data->cache.size + tile.offset;
+
+    return shaderEnd(a, &vars, pixel, data->mapping[pixels[(iu & WMask) + (iv & HMask) * tile.segment->tile_width]]);
 }
 
 static tic_color triTexTileShader(const ShaderAttr* a, s32 pixel)
@@ -821,7 +1026,11 @@ static tic_color triTexTileShader(const ShaderAttr* a, s32 pixel)
 
     enum { WMask = TIC_SPRITESHEET_SIZE - 1, HMask = TIC_SPRITESHEET_SIZE * TIC_SPRITE_BANKS - 1 };
 
-    return shaderEnd(a, &vars, pixel, data->mapping[tic_tilesheet_getpix(&data->sheet, (s32)vars.x & WMask, (s32)vars.y & HMask)]);
+    s32 x = (s32)vars.x & WMask, y = (s32)vars.y & HMask;
+    s32 width = data->sheet.segment->tile_width;
+    s32 index = ((y >> 3) << 4) + x / width;
+
+    return shaderEnd(a, &vars, pixel, data->mapping[data->cache.pixels[index * data->cache.size + (x & (width - 1)) + (y & 7) * width]]);
 }
 
 static tic_color triTexVbankShader(const ShaderAttr* a, s32 pixel)
@@ -838,6 +1047,19 @@ static tic_color triTexVbankShader(const ShaderAttr* a, s32 pixel)
     return shaderEnd(a, &vars, pixel, data->mapping[tic_tool_peek4(data->vram->data, iv * TIC80_WIDTH + iu)]);
 }
 
+// the pixel shaders are inlined into the span loops, so there is no indirect call per pixel
+#define SPAN_SHADER(NAME, PIXEL)                                                                \
+    static void NAME(tic_core* core, ShaderAttr* a, s32 pixel, s32 count, const Vec3* dw)      \
+    {                                                                                           \
+        shadeSpan(core, a, pixel, count, dw, PIXEL);                                            \
+    }
+
+SPAN_SHADER(triTexTileSpan, triTexTileShader)
+SPAN_SHADER(triTexMapSpan, triTexMapShader)
+SPAN_SHADER(triTexVbankSpan, triTexVbankShader)
+
+#undef SPAN_SHADER
+
 void tic_api_ttri(tic_mem* tic, 
     float x1, float y1, 
     float x2, float y2, 
@@ -852,12 +1074,17 @@ void tic_api_ttri(tic_mem* tic,
     if(z1 < FLT_EPSILON || z2 < FLT_EPSILON || z3 < FLT_EPSILON)
         depth = false;
 
+    tic_core* core = (tic_core*)tic;
+    tic_tilesheet sheet = getTileSheetFromSegment(tic, tic->ram->vram.blit.segment);
+
     TexData texData = 
     {
-        .sheet = getTileSheetFromSegment(tic, tic->ram->vram.blit.segment),
+        .sheet = sheet,
+        .cache = getTileCache(core, sheet.segment),
         .mapping = getPalette(tic, colors, count),
         .map = tic->ram->map.data,
         .vram = &((tic_core*)tic)->state.vbank.mem,
+        .zbuffer = core->raster.zbuffer,
         .depth = depth,
     };
 
@@ -868,17 +1095,40 @@ void tic_api_ttri(tic_mem* tic,
         {x3, y3, u3, v3, z3},
     };
 
+    // bring the tile cache up to date for the tiles the triangle can sample
+    switch(texsrc)
+    {
+    case tic_tiles_texture:
+        {
+            enum { Rows = TIC_SPRITESHEET_SIZE * TIC_SPRITE_BANKS / TIC_SPRITESIZE };
+
+            double vmin = floor(MIN3(v1, v2, v3)) - 1, vmax = floor(MAX3(v1, v2, v3)) + 1;
+            s32 top = 0, bottom = Rows - 1;
+
+            if(vmax - vmin < Rows * TIC_SPRITESIZE && fabs(vmin) < INT32_MAX / 2)
+                top = (s32)vmin >> 3, bottom = (s32)vmax >> 3;
+
+            for(s32 row = top; row <= bottom; row++)
+                updateTileCacheRange(core, &texData.cache, (row & (Rows - 1)) * TIC_SPRITESHEET_COLS, TIC_SPRITESHEET_COLS);
+        }
+        break;
+    case tic_map_texture:
+        updateTileCacheRange(core, &texData.cache, sheet.segment->bank_orig * TIC_BANK_SPRITES, TIC_BANK_SPRITES);
+        break;
+    default: break;
+    }
+
     if(depth)
         for(s32 i = 0; i != COUNT_OF(t); ++i)
             t[i].d.x /= t[i].d.z, 
             t[i].d.y /= t[i].d.z, 
             t[i].d.z = 1.0 / t[i].d.z;
 
-    static const PixelShader Shaders[] = 
+    static const SpanShader Shaders[] = 
     {
-        [tic_tiles_texture] = triTexTileShader,
-        [tic_map_texture]   = triTexMapShader,
-        [tic_vbank_texture] = triTexVbankShader,
+        [tic_tiles_texture] = triTexTileSpan,
+        [tic_map_texture]   = triTexMapSpan,
+        [tic_vbank_texture] = triTexVbankSpan,
     };
     
     if(texsrc >= 0 && texsrc < COUNT_OF(Shaders))
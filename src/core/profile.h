@@ -0,0 +1,145 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "core.h"
+
+// routes the calls of a language binding through the profiler, the core
+// sources don't include it, so calls made inside the core are not counted
+
+#define TIC_PROFILE_VOID(name, params, args)                \
+    static inline void tic_profile_##name params            \
+    {                                                       \
+        tic_core_profile_begin(tic);                        \
+        tic_api_##name args;                                \
+        tic_core_profile_end(tic, tic_api_##name##_index);  \
+    }
+
+#define TIC_PROFILE_VALUE(name, ret, params, args)          \
+    static inline ret tic_profile_##name params             \
+    {                                                       \
+        tic_core_profile_begin(tic);                        \
+        ret result = tic_api_##name args;                   \
+        tic_core_profile_end(tic, tic_api_##name##_index);  \
+        return result;                                      \
+    }
+
+TIC_PROFILE_VALUE(print, s32, (tic_mem* tic, const char* text, s32 x, s32 y, u8 color, bool fixed, s32 scale, bool alt), (tic, text, x, y, color, fixed, scale, alt))
+TIC_PROFILE_VOID(cls, (tic_mem* tic, u8 color), (tic, color))
+TIC_PROFILE_VALUE(pix, u8, (tic_mem* tic, s32 x, s32 y, u8 color, bool get), (tic, x, y, color, get))
+TIC_PROFILE_VOID(line, (tic_mem* tic, float x1, float y1, float x2, float y2, u8 color), (tic, x1, y1, x2, y2, color))
+TIC_PROFILE_VOID(rect, (tic_mem* tic, s32 x, s32 y, s32 width, s32 height, u8 color), (tic, x, y, width, height, color))
+TIC_PROFILE_VOID(rectb, (tic_mem* tic, s32 x, s32 y, s32 width, s32 height, u8 color), (tic, x, y, width, height, color))
+TIC_PROFILE_VOID(spr, (tic_mem* tic, s32 index, s32 x, s32 y, s32 w, s32 h, u8* trans_colors, u8 trans_count, s32 scale, tic_flip flip, tic_rotate rotate), (tic, index, x, y, w, h, trans_colors, trans_count, scale, flip, rotate))
+TIC_PROFILE_VALUE(btn, u32, (tic_mem* tic, s32 id), (tic, id))
+TIC_PROFILE_VALUE(btnp, u32, (tic_mem* tic, s32 id, s32 hold, s32 period), (tic, id, hold, period))
+TIC_PROFILE_VOID(sfx, (tic_mem* tic, s32 index, s32 note, s32 octave, s32 duration, s32 channel, s32 left, s32 right, s32 speed), (tic, index, note, octave, duration, channel, left, right, speed))
+TIC_PROFILE_VOID(map, (tic_mem* tic, s32 x, s32 y, s32 width, s32 height, s32 sx, s32 sy, u8* trans_colors, u8 trans_count, s32 scale, RemapFunc remap, void* data), (tic, x, y, width, height, sx, sy, trans_colors, trans_count, scale, remap, data))
+TIC_PROFILE_VALUE(mget, u8, (tic_mem* tic, s32 x, s32 y), (tic, x, y))
+TIC_PROFILE_VOID(mset, (tic_mem* tic, s32 x, s32 y, u8 value), (tic, x, y, value))
+TIC_PROFILE_VALUE(peek, u8, (tic_mem* tic, s32 address, s32 bits), (tic, address, bits))
+TIC_PROFILE_VOID(poke, (tic_mem* tic, s32 address, u8 value, s32 bits), (tic, address, value, bits))
+TIC_PROFILE_VALUE(peek1, u8, (tic_mem* tic, s32 address), (tic, address))
+TIC_PROFILE_VOID(poke1, (tic_mem* tic, s32 address, u8 value), (tic, address, value))
+TIC_PROFILE_VALUE(peek2, u8, (tic_mem* tic, s32 address), (tic, address))
+TIC_PROFILE_VOID(poke2, (tic_mem* tic, s32 address, u8 value), (tic, address, value))
+TIC_PROFILE_VALUE(peek4, u8, (tic_mem* tic, s32 address), (tic, address))
+TIC_PROFILE_VOID(poke4, (tic_mem* tic, s32 address, u8 value), (tic, address, value))
+TIC_PROFILE_VOID(memcpy, (tic_mem* tic, s32 dst, s32 src, s32 size), (tic, dst, src, size))
+TIC_PROFILE_VOID(memset, (tic_mem* tic, s32 dst, u8 val, s32 size), (tic, dst, val, size))
+TIC_PROFILE_VOID(trace, (tic_mem* tic, const char* text, u8 color), (tic, text, color))
+TIC_PROFILE_VALUE(pmem, u32, (tic_mem* tic, s32 index, u32 value, bool get), (tic, index, value, get))
+TIC_PROFILE_VALUE(time, double, (tic_mem* tic), (tic))
+TIC_PROFILE_VALUE(tstamp, s32, (tic_mem* tic), (tic))
+TIC_PROFILE_VALUE(cpu, double, (tic_mem* tic), (tic))
+TIC_PROFILE_VOID(exit, (tic_mem* tic), (tic))
+TIC_PROFILE_VALUE(font, s32, (tic_mem* tic, const char* text, s32 x, s32 y, u8* trans_colors, u8 trans_count, s32 w, s32 h, bool fixed, s32 scale, bool alt), (tic, text, x, y, trans_colors, trans_count, w, h, fixed, scale, alt))
+TIC_PROFILE_VALUE(mouse, tic_point, (tic_mem* tic), (tic))
+TIC_PROFILE_VOID(circ, (tic_mem* tic, s32 x, s32 y, s32 radius, u8 color), (tic, x, y, radius, color))
+TIC_PROFILE_VOID(circb, (tic_mem* tic, s32 x, s32 y, s32 radius, u8 color), (tic, x, y, radius, color))
+TIC_PROFILE_VOID(elli, (tic_mem* tic, s32 x, s32 y, s32 a, s32 b, u8 color), (tic, x, y, a, b, color))
+TIC_PROFILE_VOID(ellib, (tic_mem* tic, s32 x, s32 y, s32 a, s32 b, u8 color), (tic, x, y, a, b, color))
+TIC_PROFILE_VOID(tri, (tic_mem* tic, float x1, float y1, float x2, float y2, float x3, float y3, u8 color), (tic, x1, y1, x2, y2, x3, y3, color))
+TIC_PROFILE_VOID(trib, (tic_mem* tic, float x1, float y1, float x2, float y2, float x3, float y3, u8 color), (tic, x1, y1, x2, y2, x3, y3, color))
+TIC_PROFILE_VOID(ttri, (tic_mem* tic, float x1, float y1, float x2, float y2, float x3, float y3, float u1, float v1, float u2, float v2, float u3, float v3, tic_texture_src texsrc, u8* colors, s32 count, float z1, float z2, float z3, bool depth), (tic, x1, y1, x2, y2, x3, y3, u1, v1, u2, v2, u3, v3, texsrc, colors, count, z1, z2, z3, depth))
+TIC_PROFILE_VOID(clip, (tic_mem* tic, s32 x, s32 y, s32 width, s32 height), (tic, x, y, width, height))
+TIC_PROFILE_VOID(music, (tic_mem* tic, s32 track, s32 frame, s32 row, bool loop, bool sustain, s32 tempo, s32 speed), (tic, track, frame, row, loop, sustain, tempo, speed))
+TIC_PROFILE_VOID(sync, (tic_mem* tic, u32 mask, s32 bank, bool toCart), (tic, mask, bank, toCart))
+TIC_PROFILE_VALUE(vbank, s32, (tic_mem* tic, s32 bank), (tic, bank))
+TIC_PROFILE_VOID(reset, (tic_mem* tic), (tic))
+TIC_PROFILE_VALUE(key, bool, (tic_mem* tic, tic_key key), (tic, key))
+TIC_PROFILE_VALUE(keyp, bool, (tic_mem* tic, tic_key key, s32 hold, s32 period), (tic, key, hold, period))
+TIC_PROFILE_VALUE(fget, bool, (tic_mem* tic, s32 index, u8 flag), (tic, index, flag))
+TIC_PROFILE_VOID(fset, (tic_mem* tic, s32 index, u8 flag, bool value), (tic, index, flag, value))
+
+#undef TIC_PROFILE_VOID
+#undef TIC_PROFILE_VALUE
+
+#define tic_api_print  tic_profile_print
+#define tic_api_cls    tic_profile_cls
+#define tic_api_pix    tic_profile_pix
+#define tic_api_line   tic_profile_line
+#define tic_api_rect   tic_profile_rect
+#define tic_api_rectb  tic_profile_rectb
+#define tic_api_spr    tic_profile_spr
+#define tic_api_btn    tic_profile_btn
+#define tic_api_btnp   tic_profile_btnp
+#define tic_api_sfx    tic_profile_sfx
+#define tic_api_map    tic_profile_map
+#define tic_api_mget   tic_profile_mget
+#define tic_api_mset   tic_profile_mset
+#define tic_api_peek   tic_profile_peek
+#define tic_api_poke   tic_profile_poke
+#define tic_api_peek1  tic_profile_peek1
+#define tic_api_poke1  tic_profile_poke1
+#define tic_api_peek2  tic_profile_peek2
+#define tic_api_poke2  tic_profile_poke2
+#define tic_api_peek4  tic_profile_peek4
+#define tic_api_poke4  tic_profile_poke4
+#define tic_api_memcpy tic_profile_memcpy
+#define tic_api_memset tic_profile_memset
+#define tic_api_trace  tic_profile_trace
+#define tic_api_pmem   tic_profile_pmem
+#define tic_api_time   tic_profile_time
+#define tic_api_tstamp tic_profile_tstamp
+#define tic_api_cpu    tic_profile_cpu
+#define tic_api_exit   tic_profile_exit
+#define tic_api_font   tic_profile_font
+#define tic_api_mouse  tic_profile_mouse
+#define tic_api_circ   tic_profile_circ
+#define tic_api_circb  tic_profile_circb
+#define tic_api_elli   tic_profile_elli
+#define tic_api_ellib  tic_profile_ellib
+#define tic_api_tri    tic_profile_tri
+#define tic_api_trib   tic_profile_trib
+#define tic_api_ttri   tic_profile_ttri
+#define tic_api_clip   tic_profile_clip
+#define tic_api_music  tic_profile_music
+#define tic_api_sync   tic_profile_sync
+#define tic_api_vbank  tic_profile_vbank
+#define tic_api_reset  tic_profile_reset
+#define tic_api_key    tic_profile_key
+#define tic_api_keyp   tic_profile_keyp
+#define tic_api_fget   tic_profile_fget
+#define tic_api_fset   tic_profile_fset
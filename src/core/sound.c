@@ -24,8 +24,10 @@
 #include "api.h"
 #include "core.h"
 
+#include <stdlib.h>
 #include <string.h>
 #include "tic_assert.h"
+#include "tic_atomic.h"
 
 #define ENVELOPE_FREQ_SCALE 2
 #define SECONDS_PER_MINUTE 60
@@ -55,13 +57,60 @@ static s32 getSpeed(tic_core* core, const tic_track* track)
         : core->state.music.speed;
 }
 
-static s32 tick2row(tic_core* core, const tic_track* track, s32 tick)
+static void updateTimeline(tic_core* core, const tic_track* track)
 {
-    // BPM = tempo * 6 / speed
+    tic_music_timeline* timeline = &core->timeline;
+    s32 tempo = getTempo(core, track);
     s32 speed = getSpeed(core, track);
-    return speed
-        ? tick * getTempo(core, track) * DEFAULT_SPEED / speed / NOTES_PER_MINUTE
-        : 0;
+    s32 count = CLAMP(MUSIC_PATTERN_ROWS - track->rows, 0, MUSIC_PATTERN_ROWS) + 1;
+
+    if (timeline->count == count && timeline->tempo == tempo && timeline->speed == speed)
+        return;
+
+    timeline->count = count;
+    timeline->tempo = tempo;
+    timeline->speed = speed;
+    timeline->row = 0;
+
+    // BPM = tempo * 6 / speed, a row starts on the first tick reaching it
+    s64 rate = (s64)tempo * DEFAULT_SPEED;
+    for (s32 row = 0; row < count; row++)
+    {
+        timeline->ticks[row] = row == 0 ? 0
+            : speed > 0 && tempo > 0
+                ? (s32)MIN(((s64)row * speed * NOTES_PER_MINUTE + rate - 1) / rate, INT32_MAX)
+                : INT32_MAX;
+    }
+}
+
+// the last row of the timeline stands for every tick past the end of the pattern
+static s32 tick2row(tic_core* core, const tic_track* track, s32 tick)
+{
+    updateTimeline(core, track);
+
+    tic_music_timeline* timeline = &core->timeline;
+    const s32* ticks = timeline->ticks;
+    s32 last = timeline->count - 1;
+    s32 row = timeline->row;
+
+    // playing moves at most a row per tick, anything else is a seek
+    if (tick >= ticks[row] && row < last && tick >= ticks[row + 1])
+        row++;
+
+    if (tick < ticks[row] || (row < last && tick >= ticks[row + 1]))
+    {
+        s32 lo = 0, hi = last;
+        while (lo < hi)
+        {
+            s32 mid = (lo + hi + 1) / 2;
+            if (tick >= ticks[mid]) lo = mid;
+            else hi = mid - 1;
+        }
+
+        row = lo;
+    }
+
+    return timeline->row = row;
 }
 
 static s32 row2tick(tic_core* core, const tic_track* track, s32 row)
@@ -77,11 +126,14 @@ static inline s32 param2val(const tic_track_row* row)
     return (row->param1 << 4) | row->param2;
 }
 
-static void update_amp(blip_buffer_t* blip, tic_sound_register_data* data, s32 new_amp)
+static void update_amp(blip_buffer_t* blip, blip_buffer_t* bus, tic_sound_register_data* data, s32 new_amp)
 {
     s32 delta = new_amp - data->amp;
     data->amp += delta;
     blip_add_delta(blip, data->time, delta);
+
+    if (bus)
+        blip_add_delta(bus, data->time, delta);
 }
 
 static inline s32 freq2period(s32 freq)
@@ -104,7 +156,7 @@ static inline s32 getAmp(const tic_sound_register* reg, s32 amp)
     return (amp * AmpMax / MAX_VOLUME) * reg->volume / MAX_VOLUME / TIC_SOUND_CHANNELS;
 }
 
-static void runEnvelope(blip_buffer_t* blip, const tic_sound_register* reg, tic_sound_register_data* data, s32 end_time, u8 volume)
+static void runEnvelope(blip_buffer_t* blip, blip_buffer_t* bus, const tic_sound_register* reg, tic_sound_register_data* data, s32 end_time, u8 volume)
 {
     s32 period = freq2period(tic_sound_register_get_freq(reg) * ENVELOPE_FREQ_SCALE);
 
@@ -112,11 +164,11 @@ static void runEnvelope(blip_buffer_t* blip, const tic_sound_register* reg, tic_
     {
         data->phase = (data->phase + 1) % WAVE_VALUES;
 
-        update_amp(blip, data, getAmp(reg, tic_tool_peek4(reg->waveform.data, data->phase) * volume / MAX_VOLUME));
+        update_amp(blip, bus, data, getAmp(reg, tic_tool_peek4(reg->waveform.data, data->phase) * volume / MAX_VOLUME));
     }
 }
 
-static void runNoise(blip_buffer_t* blip, const tic_sound_register* reg, tic_sound_register_data* data, s32 end_time, u8 volume)
+static void runNoise(blip_buffer_t* blip, blip_buffer_t* bus, const tic_sound_register* reg, tic_sound_register_data* data, s32 end_time, u8 volume)
 {
     // phase is noise LFSR, which must never be zero
     if (data->phase == 0)
@@ -128,8 +180,103 @@ static void runNoise(blip_buffer_t* blip, const tic_sound_register* reg, tic_sou
     for (; data->time < end_time; data->time += period)
     {
         data->phase = ((data->phase & 1) * fb) ^ (data->phase >> 1);
-        update_amp(blip, data, getAmp(reg, (data->phase & 1) ? volume : 0));
+        update_amp(blip, bus, data, getAmp(reg, (data->phase & 1) ? volume : 0));
+    }
+}
+
+static inline void addAmp(blip_buffer_t* blip, blip_buffer_t* bus, tic_sound_register_data* data, s32 time, s32 amp)
+{
+    if (amp != data->amp)
+    {
+        blip_add_delta(blip, time, amp - data->amp);
+
+        if (bus)
+            blip_add_delta(bus, time, amp - data->amp);
+
+        data->amp = amp;
+    }
+}
+
+// the block synth renders both sides of a channel in one walk, left and right
+// go through the same times and phases and only differ in amplitude
+typedef struct
+{
+    blip_buffer_t* blip;
+    blip_buffer_t* bus;
+    tic_sound_register_data* data;
+    s32 amp[WAVE_VALUES];
+} BlockSide;
+
+static void blockStep(BlockSide* side, s32 time, s32 phase)
+{
+    addAmp(side[0].blip, side[0].bus, side[0].data, time, side[0].amp[phase]);
+    addAmp(side[1].blip, side[1].bus, side[1].data, time, side[1].amp[phase]);
+}
+
+static void blockEnvelope(BlockSide* side, const tic_sound_register* reg, s32 end_time)
+{
+    s32 period = freq2period(tic_sound_register_get_freq(reg) * ENVELOPE_FREQ_SCALE);
+    s32 time = side->data->time;
+    s32 phase = side->data->phase;
+
+    // steps from every phase to the next one changing the amplitude, 0 if none does
+    u8 skip[WAVE_VALUES];
+    for (s32 i = WAVE_VALUES * 2 - 1, dist = 0; i >= 0; i--)
+    {
+        s32 next = (i + 1) % WAVE_VALUES, prev = i % WAVE_VALUES;
+
+        dist = side[0].amp[next] != side[0].amp[prev] || side[1].amp[next] != side[1].amp[prev]
+            ? 1 : dist ? dist + 1 : 0;
+
+        if (i < WAVE_VALUES)
+            skip[i] = dist;
     }
+
+    // the first step catches up with the volume change, the rest only where the wave changes
+    if (time < end_time)
+    {
+        phase = (phase + 1) % WAVE_VALUES;
+        blockStep(side, time, phase);
+        time += period;
+    }
+
+    for (s32 steps = time < end_time ? (end_time - time + period - 1) / period : 0; steps > 0;)
+    {
+        s32 count = skip[phase];
+
+        if (count == 0 || count > steps)
+        {
+            phase = (phase + steps) % WAVE_VALUES;
+            time += steps * period;
+            break;
+        }
+
+        phase = (phase + count) % WAVE_VALUES;
+        time += count * period;
+        steps -= count;
+
+        blockStep(side, time - period, phase);
+    }
+
+    side[0].data->time = side[1].data->time = time;
+    side[0].data->phase = side[1].data->phase = phase;
+}
+
+static void blockNoise(BlockSide* side, const tic_sound_register* reg, s32 end_time)
+{
+    s32 period = freq2period(tic_sound_register_get_freq(reg));
+    s32 fb = *reg->waveform.data ? 0x14 : 0x12000;
+    s32 time = side->data->time;
+    s32 phase = side->data->phase ? side->data->phase : 1;
+
+    for (; time < end_time; time += period)
+    {
+        phase = ((phase & 1) * fb) ^ (phase >> 1);
+        blockStep(side, time, phase & 1);
+    }
+
+    side[0].data->time = side[1].data->time = time;
+    side[0].data->phase = side[1].data->phase = phase;
 }
 
 static s32 calcLoopPos(const tic_sound_loop* loop, s32 pos)
@@ -502,10 +649,10 @@ void tic_api_sfx(tic_mem* memory, s32 index, s32 note, s32 octave, s32 duration,
     setSfxChannelData(memory, index, note, octave, duration, channel, left, right, speed);
 }
 
-static void stereo_synthesize(tic_core* core, tic_sound_register_data* registers, blip_buffer_t* blip, u8 stereoRight)
+static void stereo_synthesize(tic_core* core, tic_sound_register_data* registers, blip_buffer_t* blip, blip_buffer_t** buses, u8 stereoRight)
 {
     enum { EndTime = CLOCKRATE / TIC80_FRAMERATE };
-    s32 bufpos = (core->state.sound_ringbuf_tail + TIC_SOUND_RINGBUF_LEN - 1) % TIC_SOUND_RINGBUF_LEN;
+    s32 bufpos = (core->state.sound_ringbuf_tail + core->sound.ringlen - 1) % core->sound.ringlen;
     for (s32 i = 0; i < TIC_SOUND_CHANNELS; ++i)
     {
         u8 volume = tic_tool_peek4(&core->state.sound_ringbuf[bufpos].stereo, stereoRight + i * 2);
@@ -514,8 +661,8 @@ static void stereo_synthesize(tic_core* core, tic_sound_register_data* registers
         tic_sound_register_data* data = registers + i;
 
         tic_tool_noise(&reg->waveform)
-            ? runNoise(blip, reg, data, EndTime, volume)
-            : runEnvelope(blip, reg, data, EndTime, volume);
+            ? runNoise(blip, buses[i], reg, data, EndTime, volume)
+            : runEnvelope(blip, buses[i], reg, data, EndTime, volume);
 
         data->time -= EndTime;
     }
@@ -523,24 +670,158 @@ static void stereo_synthesize(tic_core* core, tic_sound_register_data* registers
     blip_end_frame(blip, EndTime);
 }
 
+static void block_synthesize(tic_core* core)
+{
+    enum { EndTime = CLOCKRATE / TIC80_FRAMERATE };
+    s32 bufpos = (core->state.sound_ringbuf_tail + core->sound.ringlen - 1) % core->sound.ringlen;
+    for (s32 i = 0; i < TIC_SOUND_CHANNELS; ++i)
+    {
+        const tic_stereo_volume* stereo = &core->state.sound_ringbuf[bufpos].stereo;
+        const tic_sound_register* reg = &core->state.sound_ringbuf[bufpos].registers[i];
+        bool noise = tic_tool_noise(&reg->waveform);
+
+        BlockSide side[] =
+        {
+            {core->blip.left, core->sound.bus.left[i], core->state.registers.left + i},
+            {core->blip.right, core->sound.bus.right[i], core->state.registers.right + i},
+        };
+
+        for (s32 s = 0; s < COUNT_OF(side); s++)
+        {
+            u8 volume = tic_tool_peek4(stereo, s + i * 2);
+
+            if (noise)
+            {
+                side[s].amp[0] = getAmp(reg, 0);
+                side[s].amp[1] = getAmp(reg, volume);
+            }
+            else for (s32 p = 0; p < WAVE_VALUES; p++)
+                side[s].amp[p] = getAmp(reg, tic_tool_peek4(reg->waveform.data, p) * volume / MAX_VOLUME);
+        }
+
+        if (side[0].data->time == side[1].data->time && side[0].data->phase == side[1].data->phase)
+        {
+            noise
+                ? blockNoise(side, reg, EndTime)
+                : blockEnvelope(side, reg, EndTime);
+        }
+        else for (s32 s = 0; s < COUNT_OF(side); s++)
+        {
+            u8 volume = tic_tool_peek4(stereo, s + i * 2);
+
+            noise
+                ? runNoise(side[s].blip, side[s].bus, reg, side[s].data, EndTime, volume)
+                : runEnvelope(side[s].blip, side[s].bus, reg, side[s].data, EndTime, volume);
+        }
+
+        side[0].data->time -= EndTime;
+        side[1].data->time -= EndTime;
+    }
+
+    blip_end_frame(core->blip.left, EndTime);
+    blip_end_frame(core->blip.right, EndTime);
+}
+
+static void readBuses(tic_core* core)
+{
+    enum { EndTime = CLOCKRATE / TIC80_FRAMERATE };
+    s32 count = core->memory.product.samples.count;
+
+    for (s32 i = 0; i < TIC_SOUND_CHANNELS; ++i)
+    {
+        s16* samples = core->sound.bus.samples + i * count;
+
+        blip_end_frame(core->sound.bus.left[i], EndTime);
+        blip_end_frame(core->sound.bus.right[i], EndTime);
+        blip_read_samples(core->sound.bus.left[i], samples, core->samplerate / TIC80_FRAMERATE, TIC80_SAMPLE_CHANNELS);
+        blip_read_samples(core->sound.bus.right[i], samples + 1, core->samplerate / TIC80_FRAMERATE, TIC80_SAMPLE_CHANNELS);
+    }
+}
+
+void tic_core_sound_buses(tic_mem* memory, bool enable)
+{
+    tic_core* core = (tic_core*)memory;
+
+    if (enable == (core->sound.bus.samples != NULL))
+        return;
+
+    if (enable)
+    {
+        core->sound.bus.samples = calloc(TIC_SOUND_CHANNELS, memory->product.samples.count * TIC80_SAMPLESIZE);
+
+        // no step to the current levels, the mix has long filtered them out
+        for (s32 i = 0; i < TIC_SOUND_CHANNELS; ++i)
+        {
+            blip_buffer_t** blips[] = { &core->sound.bus.left[i], &core->sound.bus.right[i] };
+
+            for (s32 s = 0; s < COUNT_OF(blips); s++)
+            {
+                // the buses are read out in the same synth that fills them
+                *blips[s] = blip_new(core->samplerate / 20);
+                blip_set_rates(*blips[s], CLOCKRATE, core->samplerate);
+            }
+        }
+    }
+    else
+    {
+        for (s32 i = 0; i < TIC_SOUND_CHANNELS; ++i)
+        {
+            blip_delete(core->sound.bus.left[i]);
+            blip_delete(core->sound.bus.right[i]);
+        }
+
+        free(core->sound.bus.samples);
+        memset(&core->sound.bus, 0, sizeof core->sound.bus);
+    }
+}
+
+const s16* tic_core_sound_bus(tic_mem* memory, s32 channel)
+{
+    tic_core* core = (tic_core*)memory;
+
+    return core->sound.bus.samples && channel >= 0 && channel < TIC_SOUND_CHANNELS
+        ? core->sound.bus.samples + channel * memory->product.samples.count
+        : NULL;
+}
+
+const tic80_sound_stats* tic_core_sound_stats(tic_mem* memory)
+{
+    return &((tic_core*)memory)->sound.stats;
+}
+
+void tic_core_synth(tic_mem* memory, tic_synth synth)
+{
+    ((tic_core*)memory)->synth = synth;
+}
+
 void tic_core_synth_sound(tic_mem* memory)
 {
     tic_core* core = (tic_core*)memory;
 
+    tic_core_profile_begin(memory);
+
     // synthesize sound using the register values found from the tail of the ring buffer
-    stereo_synthesize(core, core->state.registers.left, core->blip.left, 0);
-    stereo_synthesize(core, core->state.registers.right, core->blip.right, 1);
+    if (core->synth == tic_synth_step)
+    {
+        stereo_synthesize(core, core->state.registers.left, core->blip.left, core->sound.bus.left, 0);
+        stereo_synthesize(core, core->state.registers.right, core->blip.right, core->sound.bus.right, 1);
+    }
+    else block_synthesize(core);
 
     blip_read_samples(core->blip.left, core->memory.product.samples.buffer, core->samplerate / TIC80_FRAMERATE, TIC80_SAMPLE_CHANNELS);
     blip_read_samples(core->blip.right, core->memory.product.samples.buffer + 1, core->samplerate / TIC80_FRAMERATE, TIC80_SAMPLE_CHANNELS);
 
+    if (core->sound.bus.samples)
+        readBuses(core);
+
     // if the head has advanced, we can advance the tail too. Otherwise, we just
     // keep synthesizing audio using the last known register values, so at least we don't get crackles
-    if (core->state.sound_ringbuf_tail != core->state.sound_ringbuf_head) {
-        // note: we assume storing a 32 bit integer is atomic, that should hold on pretty much any modern processor
-        // assuming it is aligned in memory (which it should be)
-        core->state.sound_ringbuf_tail = (core->state.sound_ringbuf_tail + 1) % TIC_SOUND_RINGBUF_LEN;
-    }
+    u32 tail = core->state.sound_ringbuf_tail;
+    if (tail != tic_atomic_load(&core->state.sound_ringbuf_head))
+        tic_atomic_store(&core->state.sound_ringbuf_tail, (tail + 1) % core->sound.ringlen);
+    else core->sound.stats.underruns++;
+
+    tic_core_profile_stage(memory, tic_profile_synth);
 }
 
 void tic_core_sound_tick_start(tic_mem* memory)
@@ -567,13 +848,19 @@ void tic_core_sound_tick_end(tic_mem* memory)
 {
     tic_core* core = (tic_core*)memory;
 
-    // instead of synthesizing the sound right away, push the sound registers to the head of a ring buffer
-    core->state.sound_ringbuf[core->state.sound_ringbuf_head].stereo = memory->ram->stereo;
-    memcpy(&core->state.sound_ringbuf[core->state.sound_ringbuf_head], &memory->ram->registers, sizeof(tic_sound_register[4]));
+    // instead of synthesizing the sound right away, push the sound registers to the head of a ring buffer,
+    // the synth may run on another thread, it only reads the slot behind the tail, which the head never reaches
+    u32 head = core->state.sound_ringbuf_head;
+    core->state.sound_ringbuf[head].stereo = memory->ram->stereo;
+    memcpy(&core->state.sound_ringbuf[head], &memory->ram->registers, sizeof(tic_sound_register[4]));
 
-    if (core->state.sound_ringbuf_head != (core->state.sound_ringbuf_tail + TIC_SOUND_RINGBUF_LEN - 2) % TIC_SOUND_RINGBUF_LEN) {
-        // note: we assume storing a 32 bit integer is atomic, that should hold on pretty much any modern processor
-        // assuming it is aligned in memory (which it should be)
-        core->state.sound_ringbuf_head = (core->state.sound_ringbuf_head + 1) % TIC_SOUND_RINGBUF_LEN;
-    }
+    u32 len = core->sound.ringlen;
+    u32 tail = tic_atomic_load(&core->state.sound_ringbuf_tail);
+
+    if (head != (tail + len - 2) % len)
+        tic_atomic_store(&core->state.sound_ringbuf_head, head = (head + 1) % len);
+    else core->sound.stats.overruns++;
+
+    // the synth reads the slot behind the tail, so these registers are heard after every queued one
+    core->sound.stats.delay = (head + len - tail) % len + 1;
 }
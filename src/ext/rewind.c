@@ -0,0 +1,254 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "rewind.h"
+#include "defines.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// a delta is a sequence of <equal bytes> <literal bytes> <literal XOR values>
+// with both counts as LEB128, a literal ends at the first run of MinRun
+// equal bytes, shorter gaps are cheaper to keep as zero literals
+enum { MinRun = 8 };
+
+// records in the ring are <u32 size> <delta> <u32 size>, so the newest one can
+// be popped from the head and the oldest one dropped from the tail
+enum { RecordOverhead = sizeof(u32) * 2 };
+
+struct Rewind
+{
+    u32 size;
+    u8* state;
+    u8* delta;
+    bool valid;
+
+    struct
+    {
+        u8* data;
+        u32 size;
+        u32 head;
+        u32 used;
+        u32 count;
+    } ring;
+};
+
+static inline u64 load64(const u8* ptr)
+{
+    u64 value;
+    memcpy(&value, ptr, sizeof value);
+    return value;
+}
+
+static inline u8* writeVarint(u8* dst, u32 value)
+{
+    for(; value >= 0x80; value >>= 7)
+        *dst++ = (u8)value | 0x80;
+
+    *dst++ = (u8)value;
+    return dst;
+}
+
+static inline const u8* readVarint(const u8* src, u32* value)
+{
+    *value = 0;
+    for(s32 shift = 0;; shift += 7)
+    {
+        u8 byte = *src++;
+        *value |= (u32)(byte & 0x7f) << shift;
+        if(!(byte & 0x80)) break;
+    }
+
+    return src;
+}
+
+static u32 encode(u8* dst, const u8* cur, const u8* prev, u32 size)
+{
+    u8* out = dst;
+
+    for(u32 i = 0; i < size;)
+    {
+        u32 start = i;
+
+        while(i + sizeof(u64) <= size && load64(cur + i) == load64(prev + i))
+            i += sizeof(u64);
+
+        while(i < size && cur[i] == prev[i])
+            i++;
+
+        u32 zeros = i - start, last = i;
+
+        for(start = i; i < size && i - last < MinRun; i++)
+            if(cur[i] != prev[i])
+                last = i + 1;
+
+        out = writeVarint(out, zeros);
+        out = writeVarint(out, last - start);
+
+        for(u32 k = start; k < last; k++)
+            *out++ = cur[k] ^ prev[k];
+
+        i = last;
+    }
+
+    return (u32)(out - dst);
+}
+
+static void decode(u8* state, const u8* src, u32 size)
+{
+    const u8* end = src + size;
+
+    for(u32 i = 0; src < end;)
+    {
+        u32 zeros, count;
+        src = readVarint(src, &zeros);
+        src = readVarint(src, &count);
+
+        for(i += zeros; count--;)
+            state[i++] ^= *src++;
+    }
+}
+
+static void ringWrite(Rewind* rewind, u32 pos, const void* src, u32 size)
+{
+    u32 first = MIN(size, rewind->ring.size - pos);
+    memcpy(rewind->ring.data + pos, src, first);
+    memcpy(rewind->ring.data, (const u8*)src + first, size - first);
+}
+
+static void ringRead(const Rewind* rewind, u32 pos, void* dst, u32 size)
+{
+    u32 first = MIN(size, rewind->ring.size - pos);
+    memcpy(dst, rewind->ring.data + pos, first);
+    memcpy((u8*)dst + first, rewind->ring.data, size - first);
+}
+
+static inline u32 ringPos(const Rewind* rewind, s64 pos)
+{
+    s64 size = rewind->ring.size;
+    return (u32)(((pos % size) + size) % size);
+}
+
+static void dropOldest(Rewind* rewind)
+{
+    u32 size;
+    ringRead(rewind, ringPos(rewind, (s64)rewind->ring.head - rewind->ring.used), &size, sizeof size);
+
+    rewind->ring.used -= size + RecordOverhead;
+    rewind->ring.count--;
+}
+
+Rewind* rewind_create(u32 size, u32 budget)
+{
+    Rewind* rewind = calloc(1, sizeof(Rewind));
+
+    rewind->size = size;
+    rewind->state = malloc(size);
+
+    // worst case is a literal every other byte
+    rewind->delta = malloc(size * 2 + 16);
+
+    rewind->ring.size = MAX(budget, RecordOverhead);
+    rewind->ring.data = malloc(rewind->ring.size);
+
+    return rewind;
+}
+
+void rewind_add(Rewind* rewind, const void* state)
+{
+    if(rewind->valid)
+    {
+        u32 size = encode(rewind->delta, state, rewind->state, rewind->size);
+        u32 need = size + RecordOverhead;
+
+        if(need > rewind->ring.size)
+        {
+            rewind->ring.used = rewind->ring.count = 0;
+        }
+        else
+        {
+            while(rewind->ring.size - rewind->ring.used < need)
+                dropOldest(rewind);
+
+            u32 pos = rewind->ring.head;
+            ringWrite(rewind, pos, &size, sizeof size);
+            ringWrite(rewind, ringPos(rewind, (s64)pos + sizeof size), rewind->delta, size);
+            ringWrite(rewind, ringPos(rewind, (s64)pos + sizeof size + size), &size, sizeof size);
+
+            rewind->ring.head = ringPos(rewind, (s64)pos + need);
+            rewind->ring.used += need;
+            rewind->ring.count++;
+        }
+    }
+
+    memcpy(rewind->state, state, rewind->size);
+    rewind->valid = true;
+}
+
+bool rewind_back(Rewind* rewind, void* state)
+{
+    if(!rewind->ring.count)
+        return false;
+
+    u32 size;
+    ringRead(rewind, ringPos(rewind, (s64)rewind->ring.head - sizeof size), &size, sizeof size);
+
+    u32 pos = ringPos(rewind, (s64)rewind->ring.head - sizeof size - size);
+    ringRead(rewind, pos, rewind->delta, size);
+    decode(rewind->state, rewind->delta, size);
+
+    rewind->ring.head = ringPos(rewind, (s64)pos - sizeof size);
+    rewind->ring.used -= size + RecordOverhead;
+    rewind->ring.count--;
+
+    memcpy(state, rewind->state, rewind->size);
+
+    return true;
+}
+
+void rewind_clear(Rewind* rewind)
+{
+    rewind->ring.head = rewind->ring.used = rewind->ring.count = 0;
+    rewind->valid = false;
+}
+
+u32 rewind_count(const Rewind* rewind)
+{
+    return rewind->ring.count;
+}
+
+u32 rewind_size(const Rewind* rewind)
+{
+    return rewind->size;
+}
+
+void rewind_delete(Rewind* rewind)
+{
+    if(rewind)
+    {
+        free(rewind->state);
+        free(rewind->delta);
+        free(rewind->ring.data);
+        free(rewind);
+    }
+}
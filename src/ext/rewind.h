@@ -0,0 +1,39 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <tic80_types.h>
+
+// fixed budget history of equally sized states, every added state is stored as
+// a zero run-length coded XOR against the previous one and the oldest deltas
+// are dropped when the budget is exceeded, nothing is allocated after create
+typedef struct Rewind Rewind;
+
+Rewind* rewind_create(u32 size, u32 budget);
+void rewind_add(Rewind* rewind, const void* state);
+bool rewind_back(Rewind* rewind, void* state);
+void rewind_clear(Rewind* rewind);
+u32 rewind_count(const Rewind* rewind);
+u32 rewind_size(const Rewind* rewind);
+void rewind_delete(Rewind* rewind);
@@ -0,0 +1,162 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#include "tracing.h"
+#include "defines.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// an upper bound of the JSON an event takes, names are cut to 32 chars
+enum { MaxEventJson = 256, MinJsonSize = 64 << 10 };
+
+typedef struct
+{
+    const char* name;
+    u64 start;
+    u32 duration;
+    s16 arg;
+    u8 thread;
+} Event;
+
+struct Tracing
+{
+    Event* events;
+    u32 capacity;
+    u32 head;
+    u32 count;
+};
+
+Tracing* tracing_create(u32 capacity)
+{
+    Tracing* tracing = calloc(1, sizeof(Tracing));
+
+    if(tracing)
+    {
+        tracing->capacity = MAX(capacity, 1);
+
+        if(!(tracing->events = malloc(tracing->capacity * sizeof(Event))))
+        {
+            free(tracing);
+            tracing = NULL;
+        }
+    }
+
+    return tracing;
+}
+
+void tracing_add(Tracing* tracing, const char* name, s32 thread, u64 start, u64 end, s32 arg)
+{
+    tracing->events[tracing->head] = (Event)
+    {
+        .name = name,
+        .start = start,
+        .duration = (u32)MIN(end - start, UINT32_MAX),
+        .arg = (s16)arg,
+        .thread = (u8)thread,
+    };
+
+    tracing->head = (tracing->head + 1) % tracing->capacity;
+    tracing->count = MIN(tracing->count + 1, tracing->capacity);
+}
+
+void tracing_clear(Tracing* tracing)
+{
+    tracing->head = tracing->count = 0;
+}
+
+u32 tracing_count(const Tracing* tracing)
+{
+    return tracing->count;
+}
+
+// timestamps are written in microseconds from the earliest kept event
+void* tracing_json(const Tracing* tracing, u64 freq, s32* size)
+{
+    static const char Header[] = "{\"traceEvents\":[\n"
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"main\"}},\n"
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"audio\"}}";
+    static const char Footer[] = "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    // the buffer grows as it fills, the events take ~100 bytes on average
+    size_t capacity = MinJsonSize;
+    char* json = malloc(capacity);
+
+    if(!json)
+        return NULL;
+
+    char* ptr = json;
+    ptr += sprintf(ptr, "%s", Header);
+
+    u32 first = (tracing->head + tracing->capacity - tracing->count) % tracing->capacity;
+    u64 origin = UINT64_MAX;
+
+    // enclosing events are added after the ones they contain
+    for(u32 i = 0; i < tracing->count; i++)
+        origin = MIN(origin, tracing->events[i].start);
+
+    double scale = 1e6 / freq;
+
+    for(u32 i = 0; i < tracing->count; i++)
+    {
+        const Event* event = &tracing->events[(first + i) % tracing->capacity];
+
+        if(capacity - (ptr - json) < MaxEventJson + sizeof Footer)
+        {
+            size_t used = ptr - json;
+            char* grown = realloc(json, capacity *= 2);
+
+            if(!grown)
+            {
+                free(json);
+                return NULL;
+            }
+
+            json = grown;
+            ptr = json + used;
+        }
+
+        ptr += sprintf(ptr, ",\n{\"name\":\"%.32s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+            event->name, event->thread, (event->start - origin) * scale, event->duration * scale);
+
+        ptr += event->arg >= 0
+            ? sprintf(ptr, ",\"args\":{\"row\":%d}}", event->arg)
+            : sprintf(ptr, "}");
+    }
+
+    ptr += sprintf(ptr, "%s", Footer);
+    *size = (s32)(ptr - json);
+
+    return json;
+}
+
+void tracing_delete(Tracing* tracing)
+{
+    if(tracing)
+    {
+        free(tracing->events);
+        free(tracing);
+    }
+}
@@ -0,0 +1,45 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#pragma once
+
+#include <tic80_types.h>
+
+enum
+{
+    TracingMainThread = 1,
+    TracingAudioThread,
+};
+
+// ring of complete events in Chrome trace-event format, the newest 'capacity'
+// events are kept and nothing is allocated after create; times are in the
+// units of the tic_tick_data counter and names must be static strings
+typedef struct Tracing Tracing;
+
+Tracing* tracing_create(u32 capacity);
+void tracing_add(Tracing* tracing, const char* name, s32 thread, u64 start, u64 end, s32 arg);
+void tracing_clear(Tracing* tracing);
+u32 tracing_count(const Tracing* tracing);
+void* tracing_json(const Tracing* tracing, u64 freq, s32* size);
+void tracing_delete(Tracing* tracing);
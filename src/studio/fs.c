@@ -59,6 +59,10 @@
 #include <emscripten.h>
 #endif
 
+#if defined(__TIC_LINUX__)
+#include <sys/inotify.h>
+#endif
+
 static const char* PublicDir = TIC_HOST;
 
 struct tic_fs
@@ -165,6 +169,7 @@ static const char* stringToUtf8(const FsString* wstr)
 #define tic_rmdir _wrmdir
 #define tic_stat _wstat
 #define tic_remove _wremove
+#define tic_rename(from, to) (MoveFileExW(from, to, MOVEFILE_REPLACE_EXISTING) ? 0 : -1)
 #define tic_fopen _wfopen
 #define tic_mkdir(name) _wmkdir(name)
 #define tic_strncpy wcsncpy
@@ -191,6 +196,7 @@ typedef char FsString;
 #define tic_rmdir rmdir
 #define tic_stat stat
 #define tic_remove remove
+#define tic_rename rename
 #define tic_fopen fopen
 #define tic_mkdir(name) mkdir(name, 0777)
 #define tic_strncpy strncpy
@@ -631,20 +637,58 @@ bool fs_write(const char* name, const void* buffer, s32 size)
 
     if(file)
     {
-        fwrite(buffer, 1, size, file);
-        fclose(file);
+        bool done = fwrite(buffer, 1, size, file) == (size_t)size;
+        done = fclose(file) == 0 && done;
 
 #if defined(__EMSCRIPTEN__)
         syncfs();
 #endif
 
-        return true;
+        return done;
     }
 
     return false;
 #endif
 }
 
+// writes a temp file next to the target and renames it over the target,
+// so an interrupted write leaves either the old file or the new one
+bool fs_write_atomic(const char* path, const void* buffer, s32 size)
+{
+    char temp[TICNAME_MAX];
+    if(snprintf(temp, sizeof temp, "%s.tmp", path) >= (s32)sizeof temp)
+        return false;
+
+    if(!fs_write(temp, buffer, size))
+        return false;
+
+#if defined(BAREMETALPI)
+    f_unlink(path);
+    bool done = f_rename(temp, path) == FR_OK;
+
+    if(!done)
+        f_unlink(temp);
+#else
+    const FsString* tempString = utf8ToString(temp);
+    const FsString* pathString = utf8ToString(path);
+
+    bool done = tic_rename(tempString, pathString) == 0;
+
+    if(!done)
+        tic_remove(tempString);
+
+    freeString(tempString);
+    freeString(pathString);
+
+#if defined(__EMSCRIPTEN__)
+    syncfs();
+#endif
+
+#endif
+
+    return done;
+}
+
 void* fs_read(const char* path, s32* size)
 {
 #if defined(BAREMETALPI)
@@ -735,6 +779,156 @@ u64 fs_date(const char* path)
 #endif
 }
 
+// a burst of writes is reported once it has been quiet this long,
+// without inotify the date is checked every WatchPoll ms
+enum
+{
+    WatchSettle = 100,
+    WatchPoll = 250,
+};
+
+struct fs_watch
+{
+    char path[TICNAME_MAX];
+    u64 date;
+
+    // counter values of the last unreported change and the last date check
+    u64 change;
+    u64 poll;
+
+#if defined(__TIC_LINUX__)
+    s32 fd;
+    s32 wd;
+#endif
+};
+
+fs_watch* fs_watch_create()
+{
+    fs_watch* watch = calloc(1, sizeof(fs_watch));
+
+#if defined(__TIC_LINUX__)
+    watch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    watch->wd = -1;
+#endif
+
+    return watch;
+}
+
+#if defined(__TIC_LINUX__)
+
+// any event on the file name, or a lost one, counts as a change
+static bool readWatchEvents(fs_watch* watch)
+{
+    const char* name = strrchr(watch->path, '/');
+    name = name ? name + 1 : watch->path;
+
+    bool changed = false;
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    for(ssize_t size; (size = read(watch->fd, buffer, sizeof buffer)) > 0;)
+        for(const char* ptr = buffer; ptr < buffer + size;)
+        {
+            const struct inotify_event* event = (const struct inotify_event*)ptr;
+
+            if((event->mask & IN_Q_OVERFLOW) || (event->len && strcmp(event->name, name) == 0))
+                changed = true;
+
+            ptr += sizeof(struct inotify_event) + event->len;
+        }
+
+    return changed;
+}
+
+#endif
+
+void fs_watch_file(fs_watch* watch, const char* path)
+{
+#if defined(__TIC_LINUX__)
+    if(watch->fd >= 0)
+    {
+        // drop what is queued, it may be the studio saving the cart itself
+        readWatchEvents(watch);
+
+        if(strcmp(watch->path, path) != 0)
+        {
+            if(watch->wd >= 0)
+                inotify_rm_watch(watch->fd, watch->wd);
+
+            // editors often write a temp file and rename it over the cart,
+            // that replaces the inode, so the folder is watched instead
+            char dir[TICNAME_MAX];
+            strncpy(dir, path, sizeof dir - 1);
+            dir[sizeof dir - 1] = '\0';
+
+            char* sep = strrchr(dir, '/');
+            if(sep) *sep = '\0';
+            else strcpy(dir, ".");
+
+            watch->wd = *path
+                ? inotify_add_watch(watch->fd, sep == dir ? "/" : dir, IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_MOVED_TO)
+                : -1;
+        }
+    }
+#endif
+
+    if(watch->path != path)
+    {
+        strncpy(watch->path, path, sizeof watch->path - 1);
+        watch->path[sizeof watch->path - 1] = '\0';
+    }
+
+    watch->date = fs_date(path);
+    watch->change = 0;
+}
+
+bool fs_watch_changed(fs_watch* watch)
+{
+    if(!*watch->path)
+        return false;
+
+    u64 now = tic_sys_counter_get();
+    u64 freq = tic_sys_freq_get();
+
+#if defined(__TIC_LINUX__)
+    if(watch->wd >= 0)
+    {
+        if(readWatchEvents(watch))
+            watch->change = now;
+    }
+    else
+#endif
+    if(now - watch->poll >= freq * WatchPoll / 1000)
+    {
+        watch->poll = now;
+
+        u64 date = fs_date(watch->path);
+
+        if(date > watch->date)
+        {
+            watch->date = date;
+            watch->change = now;
+        }
+    }
+
+    if(watch->change && now - watch->change >= freq * WatchSettle / 1000)
+    {
+        watch->change = 0;
+        return true;
+    }
+
+    return false;
+}
+
+void fs_watch_delete(fs_watch* watch)
+{
+#if defined(__TIC_LINUX__)
+    if(watch->fd >= 0)
+        close(watch->fd);
+#endif
+
+    free(watch);
+}
+
 bool tic_fs_save(tic_fs* fs, const char* name, const void* data, s32 size, bool overwrite)
 {
     if(!overwrite)
@@ -56,7 +56,17 @@ void    tic_fs_dir          (tic_fs* fs, char* out);
 void    tic_fs_dirback      (tic_fs* fs);
 void    tic_fs_homedir      (tic_fs* fs);
 
+// tells when a file was changed on disk, by inotify where there is one
+// and by polling its date elsewhere; a burst of writes is reported once
+typedef struct fs_watch fs_watch;
+
+fs_watch*   fs_watch_create     ();
+void        fs_watch_file       (fs_watch* watch, const char* path);
+bool        fs_watch_changed    (fs_watch* watch);
+void        fs_watch_delete     (fs_watch* watch);
+
 u64     fs_date     (const char* name);
 bool    fs_exists   (const char* name);
 void*   fs_read     (const char* path, s32* size);
 bool    fs_write    (const char* path, const void* data, s32 size);
+bool    fs_write_atomic(const char* path, const void* data, s32 size);
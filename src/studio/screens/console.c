@@ -1307,6 +1307,21 @@ static void tabCompleteFilesAndDirs(TabCompleteData* data)
     tic_fs_enum(data->console->fs, addFileAndDirToTabComplete, finishTabCompleteAndFreeData, MOVE(*data));
 }
 
+static void tabCompleteProfile(TabCompleteData* data)
+{
+    addTabCompleteOption(data, "on");
+    addTabCompleteOption(data, "off");
+    addTabCompleteOption(data, "overlay");
+    finishTabComplete(data);
+}
+
+static void tabCompleteTracing(TabCompleteData* data)
+{
+    addTabCompleteOption(data, "start");
+    addTabCompleteOption(data, "stop");
+    finishTabComplete(data);
+}
+
 static void tabCompleteConfig(TabCompleteData* data)
 {
     addTabCompleteOption(data, "reset");
@@ -1642,6 +1657,160 @@ static void onSurfCommand(Console* console)
     gotoSurf(console->studio);
 }
 
+static void printProfile(Console* console, const tic_profile_data* data)
+{
+    char buf[TICNAME_MAX];
+    double frames = data->frames;
+    double scale = 1000.0 / data->freq / frames;
+
+    sprintf(buf, "\n%u frames, per frame:", data->frames);
+    printBack(console, buf);
+
+    printFront(console, "\nstage        calls         ms");
+    for(s32 i = 0; i < TIC_PROFILE_STAGES; i++)
+    {
+        const tic_profile_item* item = &data->total.stage[i];
+        sprintf(buf, "\n%-10s%8.1f%11.3f", ProfileStageNames[i], item->calls / frames, item->time * scale);
+        printBack(console, buf);
+    }
+
+    printFront(console, "\napi          calls         ms");
+
+    bool used[TIC_API_COUNT] = {0};
+
+    // most expensive first
+    for(;;)
+    {
+        s32 top = -1;
+
+        for(s32 i = 0; i < TIC_API_COUNT; i++)
+            if(!used[i] && data->total.api[i].calls && (top < 0 || data->total.api[i].time > data->total.api[top].time))
+                top = i;
+
+        if(top < 0)
+            break;
+
+        used[top] = true;
+
+        const tic_profile_item* item = &data->total.api[top];
+        sprintf(buf, "\n%-10s%8.1f%11.3f", ApiNames[top], item->calls / frames, item->time * scale);
+        printBack(console, buf);
+    }
+}
+
+// the delay adds the frames queued in the core ring and on the host
+static void printSoundStats(Console* console)
+{
+    const tic80_sound_stats* core = tic_core_sound_stats(console->tic);
+    const tic80_sound_stats* host = studioSoundHost(console->studio);
+
+    char buf[TICNAME_MAX];
+
+    printFront(console, "\nsound      delay  under   over");
+    sprintf(buf, "\n%-10s%6d%7u%7u", "core", core->delay, core->underruns, core->overruns);
+    printBack(console, buf);
+    sprintf(buf, "\n%-10s%6d%7u%7u", "host", host->delay, host->underruns, host->overruns);
+    printBack(console, buf);
+    sprintf(buf, "\n%-10s%6d", "total", core->delay + host->delay);
+    printBack(console, buf);
+}
+
+static void printScriptInit(Console* console)
+{
+    const tic_script_init* init = tic_core_script_init(console->tic);
+
+    if(init->freq)
+    {
+        char buf[TICNAME_MAX];
+        sprintf(buf, "\nscript start %.3f ms, %s", init->time * 1000.0 / init->freq, init->cached ? "from cache" : "from source");
+        printBack(console, buf);
+    }
+}
+
+static void onProfileCommand(Console* console)
+{
+    tic_mem* tic = console->tic;
+
+    if(console->desc->count)
+    {
+        const char* param = console->desc->params->key;
+
+        if(strcmp(param, "on") == 0 || strcmp(param, "overlay") == 0)
+        {
+            tic_core_profile(tic, true);
+            setStudioProfileOverlay(console->studio, strcmp(param, "overlay") == 0);
+            printBack(console, "\nprofiling is on, run the cart and type `profile` to see the results");
+        }
+        else if(strcmp(param, "off") == 0)
+        {
+            tic_core_profile(tic, false);
+            setStudioProfileOverlay(console->studio, false);
+            printBack(console, "\nprofiling is off");
+        }
+        else
+        {
+            printError(console, "\nunknown parameter:\n");
+            printError(console, param);
+        }
+    }
+    else
+    {
+        const tic_profile_data* data = tic_core_profile_data(tic);
+
+        printScriptInit(console);
+
+        if(!data)
+            printError(console, "\nprofiling is off, use `profile on` first");
+        else if(!data->frames)
+            printBack(console, "\nno frames profiled yet, run the cart first");
+        else
+        {
+            printProfile(console, data);
+            printSoundStats(console);
+        }
+    }
+
+    commandDone(console);
+}
+
+static void onTracingCommand(Console* console)
+{
+    Studio* studio = console->studio;
+
+    if(console->desc->count && strcmp(console->desc->params->key, "start") == 0)
+    {
+        studioStartTracing(studio);
+        printBack(console, "\ntracing started");
+    }
+    else if(console->desc->count && strcmp(console->desc->params->key, "stop") == 0)
+    {
+        const char* name = console->desc->count > 1 ? console->desc->params[1].key : "trace.json";
+
+        s32 size = 0;
+        void* json = studioStopTracing(studio, &size);
+
+        if(!json)
+            printError(console, "\ntracing is not started");
+        else if(tic_fs_save(console->fs, name, json, size, true))
+        {
+            printFront(console, "\n");
+            printFront(console, name);
+            printBack(console, " saved, open it in chrome://tracing or ui.perfetto.dev");
+        }
+        else printError(console, "\ntrace not saved :(");
+
+        free(json);
+    }
+    else if(console->desc->count)
+    {
+        printError(console, "\nunknown parameter:\n");
+        printError(console, console->desc->params->key);
+    }
+    else printBack(console, studioTracing(studio) ? "\ntracing is on" : "\ntracing is off");
+
+    commandDone(console);
+}
+
 static void loadExternal(Console* console, const char* path)
 {
     CommandDesc desc =
@@ -2933,6 +3102,27 @@ static const char HelpUsage[] = "help [<text>"
         NULL,                                                                           \
         onGameMenuCommand,                                                              \
         NULL,                                                                           \
+        NULL)                                                                           \
+                                                                                        \
+    macro("profile",                                                                    \
+        NULL,                                                                           \
+        "time the cart API calls and the TIC, SCN, BDR callbacks,\n"                    \
+        "use `overlay` to show the last frame over the running cart,\n"                 \
+        "run without params to print the average frame and how long\n"                  \
+        "the last cart start took.",                                                    \
+        "profile [on|off|overlay]",                                                     \
+        onProfileCommand,                                                               \
+        tabCompleteProfile,                                                             \
+        NULL)                                                                           \
+                                                                                        \
+    macro("tracing",                                                                    \
+        NULL,                                                                           \
+        "record a Chrome trace of the frames: tick, SCN, BDR, blit,\n"                  \
+        "sound, GIF recording and presenting, the newest events are\n"                  \
+        "kept when the buffer is full.",                                                \
+        "tracing [start|stop [file]]",                                                  \
+        onTracingCommand,                                                               \
+        tabCompleteTracing,                                                             \
         NULL)                                                                           \
     ADDGET_FILE(macro)
 
@@ -26,6 +26,230 @@
 #include "ext/md5.h"
 #include <time.h>
 
+#if defined(__EMSCRIPTEN__) || defined(BAREMETALPI) || defined(_3DS)
+#define PMEM_SYNC_SAVE
+#elif defined(__TIC_WINDOWS__)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+enum { RewindBudget = 16 << 20 };
+
+// min delay between pmem writes, ms
+enum { PMemInterval = 500 };
+
+// pmem is written on a background thread, an update which comes
+// while the previous one is still waiting replaces it
+typedef struct PMemSaver
+{
+    char path[TICNAME_MAX];
+    tic_persistent data;
+
+    bool threaded;
+    bool pending;
+    bool busy;
+    bool quit;
+
+    RunPMemStats stats;
+
+#if defined(PMEM_SYNC_SAVE)
+#elif defined(__TIC_WINDOWS__)
+    CRITICAL_SECTION lock;
+    CONDITION_VARIABLE wake;
+    CONDITION_VARIABLE idle;
+    HANDLE thread;
+#else
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t idle;
+    pthread_t thread;
+#endif
+} PMemSaver;
+
+#if defined(PMEM_SYNC_SAVE)
+
+#define saverLock(saver)
+#define saverUnlock(saver)
+#define saverWait(saver, cond)
+#define saverWake(saver, cond)
+
+#elif defined(__TIC_WINDOWS__)
+
+#define saverLock(saver) EnterCriticalSection(&(saver)->lock)
+#define saverUnlock(saver) LeaveCriticalSection(&(saver)->lock)
+#define saverWait(saver, cond) SleepConditionVariableCS(&(saver)->cond, &(saver)->lock, INFINITE)
+#define saverWake(saver, cond) WakeAllConditionVariable(&(saver)->cond)
+
+#else
+
+#define saverLock(saver) pthread_mutex_lock(&(saver)->lock)
+#define saverUnlock(saver) pthread_mutex_unlock(&(saver)->lock)
+#define saverWait(saver, cond) pthread_cond_wait(&(saver)->cond, &(saver)->lock)
+#define saverWake(saver, cond) pthread_cond_broadcast(&(saver)->cond)
+
+#endif
+
+// called locked, the lock is released while writing
+static void writePMem(PMemSaver* saver)
+{
+    char path[TICNAME_MAX];
+    tic_persistent data;
+
+    strcpy(path, saver->path);
+    data = saver->data;
+    saver->pending = false;
+    saver->busy = true;
+
+    saverUnlock(saver);
+    bool done = fs_write_atomic(path, &data, sizeof data);
+    saverLock(saver);
+
+    saver->busy = false;
+    done ? saver->stats.writes++ : saver->stats.failed++;
+
+    saverWake(saver, idle);
+}
+
+static void saverLoop(PMemSaver* saver)
+{
+    saverLock(saver);
+
+    while(saver->pending || !saver->quit)
+    {
+        if(saver->pending)
+            writePMem(saver);
+        else
+            saverWait(saver, wake);
+    }
+
+    saverUnlock(saver);
+}
+
+#if defined(PMEM_SYNC_SAVE)
+
+static bool startSaver(PMemSaver* saver)
+{
+    return false;
+}
+
+static void stopSaver(PMemSaver* saver) {}
+
+#elif defined(__TIC_WINDOWS__)
+
+static DWORD WINAPI saverThread(LPVOID data)
+{
+    saverLoop(data);
+    return 0;
+}
+
+static bool startSaver(PMemSaver* saver)
+{
+    InitializeCriticalSection(&saver->lock);
+    InitializeConditionVariable(&saver->wake);
+    InitializeConditionVariable(&saver->idle);
+
+    saver->thread = CreateThread(NULL, 0, saverThread, saver, 0, NULL);
+
+    return saver->thread != NULL;
+}
+
+static void stopSaver(PMemSaver* saver)
+{
+    if(saver->threaded)
+    {
+        WaitForSingleObject(saver->thread, INFINITE);
+        CloseHandle(saver->thread);
+    }
+
+    DeleteCriticalSection(&saver->lock);
+}
+
+#else
+
+static void* saverThread(void* data)
+{
+    saverLoop(data);
+    return NULL;
+}
+
+static bool startSaver(PMemSaver* saver)
+{
+    pthread_mutex_init(&saver->lock, NULL);
+    pthread_cond_init(&saver->wake, NULL);
+    pthread_cond_init(&saver->idle, NULL);
+
+    return pthread_create(&saver->thread, NULL, saverThread, saver) == 0;
+}
+
+static void stopSaver(PMemSaver* saver)
+{
+    if(saver->threaded)
+        pthread_join(saver->thread, NULL);
+
+    pthread_cond_destroy(&saver->idle);
+    pthread_cond_destroy(&saver->wake);
+    pthread_mutex_destroy(&saver->lock);
+}
+
+#endif
+
+static PMemSaver* createSaver()
+{
+    PMemSaver* saver = calloc(1, sizeof(PMemSaver));
+
+    // without a thread the saver writes on the caller's thread
+    saver->threaded = startSaver(saver);
+
+    return saver;
+}
+
+static void freeSaver(PMemSaver* saver)
+{
+    saverLock(saver);
+    saver->quit = true;
+    saverWake(saver, wake);
+    saverUnlock(saver);
+
+    stopSaver(saver);
+    free(saver);
+}
+
+static void countPMemUpdate(PMemSaver* saver, bool coalesced)
+{
+    saverLock(saver);
+    saver->stats.updates++;
+
+    if(coalesced)
+        saver->stats.coalesced++;
+
+    saverUnlock(saver);
+}
+
+static void savePMem(Run* run)
+{
+    PMemSaver* saver = run->saver;
+
+    saverLock(saver);
+
+    if(saver->pending)
+        saver->stats.coalesced++;
+
+    strcpy(saver->path, tic_fs_pathroot(run->fs, run->saveid));
+    saver->data = run->pmem;
+    saver->pending = true;
+
+    if(saver->threaded)
+        saverWake(saver, wake);
+    else
+        writePMem(saver);
+
+    saverUnlock(saver);
+
+    run->pmemState.dirty = false;
+    run->pmemState.saved = tic_sys_counter_get();
+}
+
 static void onTrace(void* data, const char* text, u8 color)
 {
 #if defined(BUILD_EDITORS)
@@ -98,6 +322,15 @@ static void initPMemName(Run* run)
     strcat(run->saveid, md5);
 }
 
+static bool isKeyMapped(tic_mem* tic, tic_key key)
+{
+    for(s32 i = 0; i < COUNT_OF(tic->ram->mapping.data); i++)
+        if(tic->ram->mapping.data[i] == key)
+            return true;
+
+    return false;
+}
+
 static void tick(Run* run)
 {
     if (getStudioMode(run->studio) != TIC_RUN_MODE)
@@ -105,16 +338,29 @@ static void tick(Run* run)
 
     tic_mem* tic = run->tic;
 
+    // the cart is not ticked while F10 is held, so it never sees the key
+    if(getConfig(run->studio)->rewind && tic_api_key(tic, tic_key_f10) && !isKeyMapped(tic, tic_key_f10))
+    {
+        tic_core_rewind_back(tic);
+        return;
+    }
+
     tic_core_tick(tic, &run->tickData);
+    tic_core_rewind_push(tic);
 
     enum {Size = sizeof(tic_persistent)};
 
     if(memcmp(run->pmem.data, tic->ram->persistent.data, Size))
     {
-        tic_fs_saveroot(run->fs, run->saveid, &tic->ram->persistent, Size, true);
         memcpy(run->pmem.data, tic->ram->persistent.data, Size);
+        countPMemUpdate(run->saver, run->pmemState.dirty);
+        run->pmemState.dirty = true;
     }
 
+    if(run->pmemState.dirty
+        && tic_sys_counter_get() - run->pmemState.saved >= PMemInterval * tic_sys_freq_get() / 1000)
+        savePMem(run);
+
     if(run->exit)
 #if defined(BUILD_EDITORS)
         setStudioMode(run->studio, TIC_CONSOLE_MODE);
@@ -123,6 +369,53 @@ static void tick(Run* run)
 #endif
 }
 
+// one file per cart and kind, it starts with the key of the source it was made from
+static const char* cachePath(Run* run, const char* kind)
+{
+    static char name[TICNAME_MAX];
+    snprintf(name, sizeof name, TIC_SCRIPT_CACHE "%s.%s", run->saveid + STRLEN(TIC_LOCAL), kind);
+    return name;
+}
+
+static void* loadCache(void* data, const char* kind, const char* key, s32* size)
+{
+    Run* run = data;
+
+    s32 fileSize = 0;
+    u8* buffer = tic_fs_loadroot(run->fs, cachePath(run, kind), &fileSize);
+
+    if(buffer)
+    {
+        s32 keySize = (s32)strlen(key) + 1;
+
+        if(fileSize >= keySize && memcmp(buffer, key, keySize) == 0)
+        {
+            *size = fileSize - keySize;
+            memmove(buffer, buffer + keySize, *size);
+            return buffer;
+        }
+
+        free(buffer);
+    }
+
+    return NULL;
+}
+
+static void saveCache(void* data, const char* kind, const char* key, const void* buffer, s32 size)
+{
+    Run* run = data;
+
+    s32 keySize = (s32)strlen(key) + 1;
+    u8* file = malloc(keySize + size);
+
+    if(file) SCOPE(free(file))
+    {
+        memcpy(file, key, keySize);
+        memcpy(file + keySize, buffer, size);
+        fs_write_atomic(tic_fs_pathroot(run->fs, cachePath(run, kind)), file, keySize + size);
+    }
+}
+
 static u64 getFreq(void* data)
 {
     return tic_sys_freq_get();
@@ -135,8 +428,16 @@ static u64 getCounter(void* data)
 
 void initRun(Run* run, Console* console, tic_fs* fs, Studio* studio)
 {
+    // a restart from run mode comes here without leaving it, so the pending
+    // pmem of the last run is written before it is reset and read back
+    if(run->saver)
+        flushRun(run);
+
+    PMemSaver* saver = run->saver ? run->saver : createSaver();
+
     *run = (Run)
     {
+        .saver = saver,
         .studio = studio,
         .tic = getMemory(studio),
         .console = console,
@@ -150,7 +451,10 @@ void initRun(Run* run, Console* console, tic_fs* fs, Studio* studio)
             .exit = onExit,
             .data = run,
             .counter = getCounter,
-            .freq = getFreq
+            .freq = getFreq,
+            .cacheLoad = loadCache,
+            .cacheSave = saveCache,
+            .budget = getConfig(studio)->budget,
         },
     };
 
@@ -172,10 +476,39 @@ void initRun(Run* run, Console* console, tic_fs* fs, Studio* studio)
         memcpy(run->pmem.data, run->tic->ram->persistent.data, Size);
     }
 
+    tic_core_rewind_init(run->tic, getConfig(studio)->rewind ? RewindBudget : 0);
+
     tic_sys_preseed();
 }
 
+RunPMemStats flushRun(Run* run)
+{
+    PMemSaver* saver = run->saver;
+
+    if(!saver)
+        return (RunPMemStats){0};
+
+    if(run->pmemState.dirty)
+        savePMem(run);
+
+    saverLock(saver);
+
+    while(saver->pending || saver->busy)
+        saverWait(saver, idle);
+
+    RunPMemStats stats = saver->stats;
+    saverUnlock(saver);
+
+    return stats;
+}
+
 void freeRun(Run* run)
 {
+    if(run->saver)
+    {
+        flushRun(run);
+        freeSaver(run->saver);
+    }
+
     free(run);
 }
\ No newline at end of file
@@ -27,6 +27,14 @@
 
 typedef struct Run Run;
 
+typedef struct
+{
+    s32 updates;    // frames which changed pmem
+    s32 writes;     // files written
+    s32 coalesced;  // updates folded into a later write
+    s32 failed;
+} RunPMemStats;
+
 struct Run
 {
     Studio* studio;
@@ -40,8 +48,19 @@ struct Run
     char saveid[TICNAME_MAX];
     tic_persistent pmem;
 
+    struct
+    {
+        bool dirty;
+        u64 saved;
+    } pmemState;
+
+    struct PMemSaver* saver;
+
     void(*tick)(Run*);
 };
 
 void initRun(Run*, struct Console*, struct tic_fs*, Studio* studio);
 void freeRun(Run* run);
+
+// waits until every pmem update is on disk
+RunPMemStats flushRun(Run* run);
@@ -131,7 +131,7 @@ struct Studio
     struct
     {
         CartHash hash;
-        u64 mdate;
+        fs_watch* watch;
     }cart;
 
     struct
@@ -178,6 +178,11 @@ struct Studio
         char text[STUDIO_TEXT_BUFFER_WIDTH];
     } tooltip;
 
+    struct
+    {
+        bool overlay;
+    } profile;
+
     struct
     {
         bool record;
@@ -205,6 +210,13 @@ struct Studio
     Surf*       surf;
 
     tic_net* net;
+
+    struct
+    {
+        tic80_input input;
+        s32 frames;
+        bool skip;
+    } idle;
 #endif
 
     Start*      start;
@@ -214,6 +226,15 @@ struct Studio
 
     StudioMainMenu* mainmenu;
 
+    struct
+    {
+        Tracing* events;
+        char* path;
+    } tracing;
+
+    // queued on the host side of the core, reported by the platform
+    tic80_sound_stats soundHost;
+
     tic_fs* fs;
     s32 samplerate;
     tic_font systemFont;
@@ -1224,7 +1245,10 @@ void setStudioMode(Studio* studio, EditorMode mode)
         EditorMode prev = studio->mode;
 
         if(prev == TIC_RUN_MODE)
+        {
             tic_core_pause(studio->tic);
+            flushRun(studio->run);
+        }
 
         if(mode != TIC_RUN_MODE)
             tic_api_reset(studio->tic);
@@ -1477,9 +1501,9 @@ static void updateHash(Studio* studio)
     md5(&studio->tic->cart, sizeof(tic_cartridge), studio->cart.hash.data);
 }
 
-static void updateMDate(Studio* studio)
+static void watchCart(Studio* studio)
 {
-    studio->cart.mdate = fs_date(studio->console->rom.path);
+    fs_watch_file(studio->cart.watch, studio->console->rom.path);
 }
 #endif
 
@@ -1524,7 +1548,7 @@ void studioRomSaved(Studio* studio)
 {
     updateTitle(studio);
     updateHash(studio);
-    updateMDate(studio);
+    watchCart(studio);
 }
 
 void studioRomLoaded(Studio* studio)
@@ -1533,7 +1557,7 @@ void studioRomLoaded(Studio* studio)
 
     updateTitle(studio);
     updateHash(studio);
-    updateMDate(studio);
+    watchCart(studio);
 }
 
 bool studioCartChanged(Studio* studio)
@@ -1842,7 +1866,7 @@ static void reloadConfirm(Studio* studio, bool yes, void* data)
     if(yes)
         studio->console->updateProject(studio->console);
     else
-        updateMDate(studio);
+        watchCart(studio);
 }
 
 static void checkChanges(Studio* studio)
@@ -1855,9 +1879,7 @@ static void checkChanges(Studio* studio)
         {
             Console* console = studio->console;
 
-            u64 date = fs_date(console->rom.path);
-
-            if(studio->cart.mdate && date > studio->cart.mdate)
+            if(fs_watch_changed(studio->cart.watch))
             {
                 if(studioCartChanged(studio) && studio->mode != TIC_MENU_MODE)
                 {
@@ -1893,6 +1915,83 @@ static void drawRecordLabel(Studio* studio, u32* frame, s32 sx, s32 sy)
     drawBitIconRaw(studio, frame, sx + TIC_SPRITESIZE, sy, tic_icon_rec2, tic_color_red);
 }
 
+static void drawTextRaw(Studio* studio, u32* frame, s32 x, s32 y, const char* text, tic_color color)
+{
+    const tic_font_data* font = &studio->systemFont.regular;
+    u32 rgba = tic_rgba(&getConfig(studio)->cart->bank0.palette.vbank0.colors[color]);
+
+    for(; *text; text++, x += TIC_FONT_WIDTH)
+    {
+        u8 symbol = *text;
+        if(symbol >= TIC_FONT_CHARS - 1)
+            continue;
+
+        const u8* glyph = font->data + symbol * BITS_IN_BYTE;
+        u32* dst = frame + x + y * TIC80_FULLWIDTH;
+
+        for(s32 row = 0; row != TIC_FONT_HEIGHT; row++, dst += TIC80_FULLWIDTH)
+            for(s32 col = 0; col != TIC_FONT_WIDTH; col++)
+                if(tic_tool_peek1(glyph, col + row * BITS_IN_BYTE))
+                    dst[col] = rgba;
+    }
+}
+
+void setStudioProfileOverlay(Studio* studio, bool show)
+{
+    studio->profile.overlay = show;
+}
+
+// previous frame times of the stages and of the most expensive API calls
+static void drawProfileOverlay(Studio* studio, u32* frame)
+{
+    enum {Lines = TIC_PROFILE_STAGES + 5, Width = 24 * TIC_FONT_WIDTH, LineHeight = TIC_FONT_HEIGHT + 1};
+
+    const tic_profile_data* data = tic_core_profile_data(studio->tic);
+
+    if(!data || !data->frames)
+        return;
+
+    struct ProfileLine {const char* name; const tic_profile_item* item;} lines[Lines];
+    s32 count = 0;
+
+    for(s32 i = 0; i < TIC_PROFILE_STAGES; i++)
+        lines[count++] = (struct ProfileLine){ProfileStageNames[i], &data->last.stage[i]};
+
+    bool used[TIC_API_COUNT] = {0};
+
+    // pick the most expensive calls one by one
+    while(count < Lines)
+    {
+        s32 top = -1;
+
+        for(s32 i = 0; i < TIC_API_COUNT; i++)
+            if(!used[i] && data->last.api[i].calls && (top < 0 || data->last.api[i].time > data->last.api[top].time))
+                top = i;
+
+        if(top < 0)
+            break;
+
+        used[top] = true;
+        lines[count++] = (struct ProfileLine){ApiNames[top], &data->last.api[top]};
+    }
+
+    s32 sx = TIC80_MARGIN_LEFT + 1, sy = TIC80_MARGIN_TOP + 1;
+    u32 bg = tic_rgba(&getConfig(studio)->cart->bank0.palette.vbank0.colors[tic_color_black]);
+
+    for(s32 y = sy - 1, end = sy + count * LineHeight; y < end; y++)
+        for(s32 x = sx - 1; x < sx + Width; x++)
+            frame[x + y * TIC80_FULLWIDTH] = bg;
+
+    for(s32 i = 0; i < count; i++)
+    {
+        char buf[32];
+        snprintf(buf, sizeof buf, "%-10s%4u%7.2fms", lines[i].name, lines[i].item->calls,
+            lines[i].item->time * 1000.0 / data->freq);
+
+        drawTextRaw(studio, frame, sx, sy + i * LineHeight, buf, i < TIC_PROFILE_STAGES ? tic_color_green : tic_color_white);
+    }
+}
+
 static bool isRecordFrame(Studio* studio)
 {
     return studio->video.record;
@@ -2192,6 +2291,183 @@ const tic_mem* studio_mem(Studio* studio)
     return getMemory(studio);
 }
 
+// about half a minute of frames with all the SCN/BDR callbacks
+enum { TracingCapacity = 1 << 19 };
+
+void studioStartTracing(Studio* studio)
+{
+    if(studio->tracing.events)
+        tracing_clear(studio->tracing.events);
+    else
+        studio->tracing.events = tracing_create(TracingCapacity);
+
+    tic_core_tracing(studio->tic, studio->tracing.events);
+}
+
+static void* stopTracing(Studio* studio, s32* size)
+{
+    void* json = NULL;
+
+    if(studio->tracing.events)
+    {
+        tic_core_tracing(studio->tic, NULL);
+        json = tracing_json(studio->tracing.events, tic_sys_freq_get(), size);
+
+        tracing_delete(studio->tracing.events);
+        studio->tracing.events = NULL;
+    }
+
+    return json;
+}
+
+// the trace goes to the caller, so the --tracing file is not written on exit
+void* studioStopTracing(Studio* studio, s32* size)
+{
+    free(studio->tracing.path);
+    studio->tracing.path = NULL;
+
+    return stopTracing(studio, size);
+}
+
+bool studioTracing(Studio* studio)
+{
+    return studio->tracing.events != NULL;
+}
+
+const tic80_sound_stats* studioSoundHost(Studio* studio)
+{
+    return &studio->soundHost;
+}
+
+void studio_sound_stats(Studio* studio, const tic80_sound_stats* host)
+{
+    studio->soundHost = *host;
+}
+
+void studio_trace(Studio* studio, const char* name, u64 start, u64 end)
+{
+    if(studio->tracing.events)
+        tracing_add(studio->tracing.events, name, TracingMainThread, start, end, -1);
+}
+
+#if defined(BUILD_EDITORS)
+
+// an editor with no input, sound or popup draws the same frame over and
+// over, after a second of that only every half a second is drawn, it's
+// when the cursors blink and it picks up changes made by net callbacks
+enum
+{
+    IdleDelay = TIC80_FRAMERATE,
+    IdleWake = TIC80_FRAMERATE / 2,
+};
+
+// queued --cmd commands run one per frame and the selection frames march
+static bool editorBusy(Studio* studio)
+{
+    switch(studio->mode)
+    {
+    case TIC_CONSOLE_MODE:
+        {
+            Console* console = studio->console;
+            return console->commands.current < console->commands.count;
+        }
+    case TIC_SPRITE_MODE:
+        {
+            Sprite* sprite = studio->banks.sprite[studio->bank.index.sprites];
+            return sprite->mode == SPRITE_SELECT_MODE && sprite->select.rect.w && sprite->select.rect.h;
+        }
+    case TIC_MAP_MODE:
+        {
+            Map* map = studio->banks.map[studio->bank.index.map];
+            return map->paste || (map->select.rect.w > 0 && map->select.rect.h > 0);
+        }
+    default:
+        return false;
+    }
+}
+
+static bool quietFrame(Studio* studio, const tic80_input* input)
+{
+    tic_mem* tic = studio->tic;
+
+    switch(studio->mode)
+    {
+    case TIC_CONSOLE_MODE:
+    case TIC_CODE_MODE:
+    case TIC_SPRITE_MODE:
+    case TIC_MAP_MODE:
+    case TIC_WORLD_MODE:
+    case TIC_SFX_MODE:
+    case TIC_MUSIC_MODE:
+        break;
+    default:
+        return false;
+    }
+
+    char text = '\0';
+    tic_sys_keyboard_text(&text);
+
+    if(text || input->keyboard.data || input->gamepads.data
+        || input->mouse.left || input->mouse.middle || input->mouse.right
+        || input->mouse.scrollx || input->mouse.scrolly
+        || memcmp(input, &studio->idle.input, sizeof(tic80_input)))
+        return false;
+
+    if(studio->toolbarMode || studio->video.record || studio->anim.movie != &studio->anim.idle)
+        return false;
+
+    if(editorBusy(studio))
+        return false;
+
+    if(tic->ram->music_state.flag.music_status != tic_music_stop)
+        return false;
+
+    for(s32 i = 0; i < TIC_SOUND_CHANNELS; i++)
+        if(tic->ram->registers[i].volume)
+            return false;
+
+    return true;
+}
+
+// both cursors blink every TIC80_FRAMERATE ticks of their own counters
+static u32* blinkCounter(Studio* studio)
+{
+    switch(studio->mode)
+    {
+    case TIC_CODE_MODE:     return &studio->code->tickCounter;
+    case TIC_CONSOLE_MODE:  return &studio->console->tickCounter;
+    default:                return NULL;
+    }
+}
+
+static bool skipFrame(Studio* studio, const tic80_input* input)
+{
+    studio->idle.frames = quietFrame(studio, input) ? studio->idle.frames + 1 : 0;
+    studio->idle.input = *input;
+
+    u32* counter = blinkCounter(studio);
+
+    if(studio->idle.frames <= IdleDelay || (counter ? *counter : studio->idle.frames) % IdleWake == 0)
+        return false;
+
+    // skipped frames still count, so the cursor keeps its pace
+    if(counter)
+        ++*counter;
+
+    return true;
+}
+
+#endif
+
+bool studio_idle(Studio* studio)
+{
+#if defined(BUILD_EDITORS)
+    return studio->idle.skip;
+#else
+    return false;
+#endif
+}
+
 void studio_tick(Studio* studio, tic80_input input)
 {
     tic_mem* tic = studio->tic;
@@ -2201,6 +2477,16 @@ void studio_tick(Studio* studio, tic80_input input)
     processAnim(studio->anim.movie, studio);
     checkChanges(studio);
     tic_net_start(studio->net);
+
+    if((studio->idle.skip = skipFrame(studio, &input)))
+    {
+        // the synth would count every skipped frame as an underrun
+        tic_core_sound_tick_start(tic);
+        tic_core_sound_tick_end(tic);
+
+        tic_net_end(studio->net);
+        return;
+    }
 #endif
  
     if(studio->toolbarMode)
@@ -2244,7 +2530,14 @@ void studio_tick(Studio* studio, tic80_input input)
 
 #if defined(BUILD_EDITORS)
         if(isRecordFrame(studio))
+        {
+            u64 start = tic_sys_counter_get();
             recordFrame(studio, tic->product.screen);
+            studio_trace(studio, "recordFrame", start, tic_sys_counter_get());
+        }
+
+        if(studio->mode == TIC_RUN_MODE && studio->profile.overlay)
+            drawProfileOverlay(studio, tic->product.screen);
 
         drawPopup(studio);
 #endif
@@ -2319,6 +2612,18 @@ void exitGame(Studio* studio)
 
 void studio_delete(Studio* studio)
 {
+    if(studio->tracing.path)
+    {
+        s32 size = 0;
+        void* json = stopTracing(studio, &size);
+
+        if(!json || !fs_write(studio->tracing.path, json, size))
+            fprintf(stderr, "error: can't write trace to `%s`\n", studio->tracing.path);
+
+        free(json);
+        free(studio->tracing.path);
+    }
+
     {
 #if defined(BUILD_EDITORS)
         for(s32 i = 0; i < TIC_EDITOR_BANKS; i++)
@@ -2351,6 +2656,7 @@ void studio_delete(Studio* studio)
 
 #if defined(BUILD_EDITORS)
     tic_net_close(studio->net);
+    fs_watch_delete(studio->cart.watch);
     free(studio->video.buffer);
 #endif
 
@@ -2462,8 +2768,9 @@ Studio* studio_create(s32 argc, char **argv, s32 samplerate, tic80_pixel_color_f
 
         .samplerate = samplerate,
         .net = tic_net_create(TIC_WEBSITE),
+        .cart.watch = fs_watch_create(),
 #endif
-        .tic = tic_core_create(samplerate, format),
+        .tic = tic_core_create(samplerate, format, args.lowlatency ? TIC80_LATENCY_LOW : TIC80_LATENCY_DEFAULT),
     };
 
 
@@ -2529,6 +2836,7 @@ Studio* studio_create(s32 argc, char **argv, s32 samplerate, tic80_pixel_color_f
 
     tic_fs_makedir(studio->fs, TIC_LOCAL);
     tic_fs_makedir(studio->fs, TIC_LOCAL_VERSION);
+    tic_fs_makedir(studio->fs, TIC_SCRIPT_CACHE);
     
     initConfig(studio->config, studio, studio->fs);
 
@@ -2561,6 +2869,9 @@ Studio* studio_create(s32 argc, char **argv, s32 samplerate, tic80_pixel_color_f
     studio->config->data.options.vsync      |= args.vsync;
     studio->config->data.soft               |= args.soft;
     studio->config->data.cli                |= args.cli;
+    studio->config->data.lowLatency          = args.lowlatency;
+    studio->config->data.budget              = MAX(args.budget, 0);
+    studio->config->data.rewind              = args.rewind;
 
     studioConfigChanged(studio);
 
@@ -2570,5 +2881,11 @@ Studio* studio_create(s32 argc, char **argv, s32 samplerate, tic80_pixel_color_f
     if(args.skip)
         setStudioMode(studio, TIC_CONSOLE_MODE);
 
+    if(args.tracing)
+    {
+        studio->tracing.path = strdup(args.tracing);
+        studioStartTracing(studio);
+    }
+
     return studio;
 }
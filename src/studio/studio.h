@@ -42,6 +42,7 @@
 #define TIC_LOCAL ".local/"
 #define TIC_LOCAL_VERSION TIC_LOCAL TIC_VERSION_HASH "/"
 #define TIC_CACHE TIC_LOCAL "cache/"
+#define TIC_SCRIPT_CACHE TIC_LOCAL_VERSION "scripts/"
 
 #define TOOLBAR_SIZE 7
 #define STUDIO_TEXT_WIDTH (TIC_FONT_WIDTH)
@@ -78,6 +79,10 @@
     macro(cmd,          char*,  STRING,     "=<str>",   "run commands in the console")      \
     macro(keepcmd,      bool,   BOOLEAN,    "",         "re-execute commands on every run") \
     macro(version,      bool,   BOOLEAN,    "",         "print program version")            \
+    macro(tracing,      char*,  STRING,     "=<str>",   "write a frame trace on exit")      \
+    macro(lowlatency,   bool,   BOOLEAN,    "",         "queue less sound ahead")           \
+    macro(budget,       s32,    INTEGER,    "=<int>",   "script time budget per frame, ms") \
+    macro(rewind,       bool,   BOOLEAN,    "",         "hold F10 to rewind the game")      \
     CRT_CMD_PARAM(macro)
 
 #define SHOW_TOOLTIP(STUDIO, FORMAT, ...)   \
@@ -204,6 +209,11 @@ EditorMode getStudioMode(Studio* studio);
 void exitStudio(Studio* studio);
 
 void setStudioViMode(Studio* studio, ViMode mode);
+void setStudioProfileOverlay(Studio* studio, bool show);
+void studioStartTracing(Studio* studio);
+void* studioStopTracing(Studio* studio, s32* size);
+bool studioTracing(Studio* studio);
+const tic80_sound_stats* studioSoundHost(Studio* studio);
 ViMode getStudioViMode(Studio* studio);
 bool checkStudioViMode(Studio* studio, ViMode mode);
 
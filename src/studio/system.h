@@ -119,6 +119,9 @@ typedef struct
     bool checkNewVersion;
     bool cli;
     bool soft;
+    bool lowLatency;
+    u32 budget;
+    bool rewind;
 
     struct StudioOptions
     {
@@ -149,9 +152,14 @@ typedef struct Studio Studio;
 
 const tic_mem* studio_mem(Studio* studio);
 void studio_tick(Studio* studio, tic80_input input);
+
+// the last studio_tick skipped an idle frame and left the screen as it was
+bool studio_idle(Studio* studio);
 void studio_sound(Studio* studio);
 void studio_load(Studio* studio, const char* file);
 bool studio_alive(Studio* studio);
+void studio_trace(Studio* studio, const char* name, u64 start, u64 end);
+void studio_sound_stats(Studio* studio, const tic80_sound_stats* host);
 void studio_exit(Studio* studio);
 void studio_delete(Studio* studio);
 const StudioConfig* studio_config(Studio* studio);
@@ -0,0 +1,104 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "common.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "api.h"
+#include "tools.h"
+#include "ext/png.h"
+
+u64 getCounter()
+{
+#if defined(_WIN32)
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+u64 getFreq()
+{
+#if defined(_WIN32)
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    return freq.QuadPart;
+#else
+    return 1000000000;
+#endif
+}
+
+void* readFile(const char* path, s32* size)
+{
+    FILE* file = fopen(path, "rb");
+    void* buffer = NULL;
+
+    if(file)
+    {
+        fseek(file, 0, SEEK_END);
+        *size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        if((buffer = malloc(*size)) && fread(buffer, *size, 1, file) != 1)
+        {
+            free(buffer);
+            buffer = NULL;
+        }
+
+        fclose(file);
+    }
+
+    return buffer;
+}
+
+void* loadCart(const char* path, s32* size)
+{
+    void* data = readFile(path, size);
+
+    if(data && tic_tool_has_ext(path, ".png"))
+    {
+        png_buffer zip = png_decode((png_buffer){data, *size});
+        free(data);
+        data = NULL;
+
+        if(zip.size)
+        {
+            data = malloc(sizeof(tic_cartridge));
+            *size = tic_tool_unzip(data, sizeof(tic_cartridge), zip.data, zip.size);
+            free(zip.data);
+        }
+    }
+
+    return data;
+}
@@ -0,0 +1,312 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// runs a cart without window, audio device or frame pacing:
+//   tic80-headless cart.tic --frames=600 --hash=frames.txt --wav=out.wav
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tic80.h>
+#include "api.h"
+#include "tools.h"
+#include "ext/png.h"
+#include "wave_writer.h"
+#include "argparse.h"
+#include "common.h"
+
+#define TIC80_EXECUTABLE_NAME "tic80-headless"
+
+typedef struct
+{
+    s32 frame;
+    tic80_gamepads gamepads;
+    tic80_keyboard keyboard;
+} InputEvent;
+
+static struct
+{
+    const char* cart;
+    s32 frames;
+    const char* input;
+    const char* hash;
+    const char* png;
+    s32 pngevery;
+    const char* wav;
+    const char* synth;
+    s32 budget;
+
+    struct
+    {
+        InputEvent* items;
+        s32 count;
+    } events;
+
+    bool quit;
+    bool failed;
+} state =
+{
+    .frames = 600,
+    .pngevery = 60,
+};
+
+static void onTrace(void* data, const char* text, u8 color)
+{
+    printf("%s\n", text);
+}
+
+static void onError(void* data, const char* info)
+{
+    fprintf(stderr, "%s\n", info);
+    state.quit = state.failed = true;
+}
+
+static void onExit(void* data)
+{
+    state.quit = true;
+}
+
+// every line is '<frame> <gamepads> [<keyboard>]' with the masks in hex,
+// the state is held from that frame until the next line
+static bool loadInput(const char* path)
+{
+    FILE* file = fopen(path, "r");
+
+    if(!file)
+        return false;
+
+    char line[256];
+    while(fgets(line, sizeof line, file))
+    {
+        InputEvent event = {0};
+        u32 gamepads = 0, keyboard = 0;
+
+        if(sscanf(line, "%d %x %x", &event.frame, &gamepads, &keyboard) >= 2)
+        {
+            event.gamepads.data = gamepads;
+            event.keyboard.data = keyboard;
+
+            state.events.items = realloc(state.events.items, sizeof(InputEvent) * (state.events.count + 1));
+            state.events.items[state.events.count++] = event;
+        }
+    }
+
+    fclose(file);
+    return true;
+}
+
+static u32 hashScreen(const u32* screen)
+{
+    // FNV-1a
+    u32 hash = 2166136261u;
+    const u8* ptr = (const u8*)screen;
+    const u8* end = ptr + TIC80_FULLWIDTH * TIC80_FULLHEIGHT * sizeof *screen;
+
+    while(ptr != end)
+        hash = (hash ^ *ptr++) * 16777619u;
+
+    return hash;
+}
+
+static void savePng(const tic80* product, s32 frame)
+{
+    char path[1024];
+    snprintf(path, sizeof path, "%s%05d.png", state.png, frame);
+
+    png_img img = {TIC80_FULLWIDTH, TIC80_FULLHEIGHT, .values = product->screen};
+    png_buffer png = png_write(img, (png_buffer){NULL, 0});
+
+    FILE* file = fopen(path, "wb");
+    if(file)
+    {
+        fwrite(png.data, png.size, 1, file);
+        fclose(file);
+    }
+    else fprintf(stderr, "can't write %s\n", path);
+
+    free(png.data);
+}
+
+static void parseArgs(s32 argc, char **argv)
+{
+    static const char *const usage[] =
+    {
+        TIC80_EXECUTABLE_NAME " <cart> [options]",
+        NULL,
+    };
+
+    struct argparse_option options[] =
+    {
+        OPT_HELP(),
+        OPT_INTEGER('\0', "frames", &state.frames, "number of frames to run (600 by default)"),
+        OPT_STRING('\0', "input", &state.input, "input script, '<frame> <gamepads> [<keyboard>]' per line in hex"),
+        OPT_STRING('\0', "hash", &state.hash, "write a framebuffer hash per frame to the file"),
+        OPT_STRING('\0', "png", &state.png, "write frames as PNG files named <prefix><frame>.png"),
+        OPT_INTEGER('\0', "pngevery", &state.pngevery, "write every Nth frame as PNG (60 by default)"),
+        OPT_STRING('\0', "wav", &state.wav, "write the audio stream to the WAV file"),
+        OPT_STRING('\0', "synth", &state.synth, "sound synth to use, 'block' (default) or 'step'"),
+        OPT_INTEGER('\0', "budget", &state.budget, "script time budget per frame in ms, the run fails when it's over"),
+        OPT_END(),
+    };
+
+    struct argparse argparse;
+    argparse_init(&argparse, options, usage, 0);
+    argparse_describe(&argparse, "\n" TIC80_EXECUTABLE_NAME " runs a cart as fast as possible without display and audio.", NULL);
+    argc = argparse_parse(&argparse, argc, (const char**)argv);
+
+    if(argc == 1)
+        state.cart = argv[0];
+    else
+        argparse_usage(&argparse);
+}
+
+s32 main(s32 argc, char **argv)
+{
+    parseArgs(argc, argv);
+
+    if(!state.cart)
+        return 1;
+
+    s32 size = 0;
+    void* cart = loadCart(state.cart, &size);
+
+    if(!cart)
+    {
+        fprintf(stderr, "can't load cart %s\n", state.cart);
+        return 1;
+    }
+
+    if(state.input && !loadInput(state.input))
+    {
+        fprintf(stderr, "can't read input %s\n", state.input);
+        return 1;
+    }
+
+    FILE* hashFile = NULL;
+    if(state.hash && !(hashFile = fopen(state.hash, "w")))
+    {
+        fprintf(stderr, "can't write %s\n", state.hash);
+        return 1;
+    }
+
+    if(state.wav)
+    {
+        if(!wave_open(TIC80_SAMPLERATE, state.wav))
+        {
+            fprintf(stderr, "can't write %s\n", state.wav);
+            return 1;
+        }
+
+#if TIC80_SAMPLE_CHANNELS == 2
+        wave_enable_stereo();
+#endif
+    }
+
+    // RGBA byte order, so frames go to PNG as they are
+    tic80* product = tic80_create(TIC80_SAMPLERATE, TIC80_PIXEL_COLOR_RGBA8888);
+    tic_mem* tic = (tic_mem*)product;
+    tic80_load(product, cart, size);
+    free(cart);
+
+    if(state.synth)
+        tic_core_synth(tic, strcmp(state.synth, "step") == 0 ? tic_synth_step : tic_synth_block);
+
+    tic_tick_data tickData =
+    {
+        .error = onError,
+        .trace = onTrace,
+        .exit = onExit,
+        .counter = getCounter,
+        .freq = getFreq,
+        .budget = MAX(state.budget, 0),
+    };
+
+    struct
+    {
+        u64 tick;
+        u64 blit;
+        u64 synth;
+    } time = {0};
+
+    tic80_input input = {0};
+    s32 frame = 0, event = 0;
+    u64 start = getCounter();
+
+    for(; frame < state.frames && !state.quit; frame++)
+    {
+        for(; event < state.events.count && state.events.items[event].frame <= frame; event++)
+        {
+            input.gamepads = state.events.items[event].gamepads;
+            input.keyboard = state.events.items[event].keyboard;
+        }
+
+        tic->ram->input = input;
+
+        u64 t0 = getCounter();
+        tic_core_tick_start(tic);
+        tic_core_tick(tic, &tickData);
+        tic_core_tick_end(tic);
+
+        u64 t1 = getCounter();
+        tic_core_blit(tic);
+
+        u64 t2 = getCounter();
+        tic_core_synth_sound(tic);
+
+        u64 t3 = getCounter();
+
+        time.tick += t1 - t0;
+        time.blit += t2 - t1;
+        time.synth += t3 - t2;
+
+        if(hashFile)
+            fprintf(hashFile, "%d %08x\n", frame, hashScreen(product->screen));
+
+        if(state.png && state.pngevery > 0 && frame % state.pngevery == 0)
+            savePng(product, frame);
+
+        if(state.wav)
+            wave_write(product->samples.buffer, product->samples.count);
+    }
+
+    double freq = (double)getFreq();
+    double total = (getCounter() - start) / freq;
+    s32 frames = MAX(frame, 1);
+
+    printf("frames: %d\n", frame);
+    printf("time: %.3f s, %.1f ticks/s\n", total, frame / total);
+    printf("tick: %.1f us/frame\n", time.tick / freq * 1e6 / frames);
+    printf("blit: %.1f us/frame\n", time.blit / freq * 1e6 / frames);
+    printf("synth: %.1f us/frame\n", time.synth / freq * 1e6 / frames);
+
+    if(state.wav)
+        wave_close();
+
+    if(hashFile)
+        fclose(hashFile);
+
+    free(state.events.items);
+    tic80_delete(product);
+
+    return state.failed ? 1 : 0;
+}
@@ -73,6 +73,7 @@ struct tic80_state
 	float mouseYAccumulator;
 	int mouseHideTimer;
 	int mouseHideTimerStart;
+	bool vmStateReported;
 	tic80* tic;
 };
 static struct tic80_state* state;
@@ -172,6 +173,7 @@ RETRO_API void retro_init(void)
 	state->mouseXAccumulator = 0.0f;
 	state->mouseYAccumulator = 0.0f;
 	state->mouseHideTimer = state->mouseHideTimerStart;
+	state->vmStateReported = false;
 
 	// Initialize the keyboard mappings.
 	state->keymap[RETROK_UNKNOWN] = tic_key_unknown;
@@ -1012,7 +1014,6 @@ RETRO_API void retro_run(void)
 RETRO_API bool retro_load_game(const struct retro_game_info *info)
 {
 	// TODO: Warn that Audio Synchronization required to run at a proper speed.
-	// TODO: Warn that the core doesn't support Runahead.
 
 	// Initialize the core if it hasn't been yet.
 	if (state == NULL) {
@@ -1110,48 +1111,49 @@ RETRO_API bool retro_load_game_special(unsigned type, const struct retro_game_in
 }
 
 /**
- * libretro callback; Retrieve the size of the serialized memory.
+ * libretro callback; Retrieve the size of the serialized machine state.
  */
 size_t retro_serialize_size(void)
 {
-	return TIC_PERSISTENT_SIZE * sizeof(u32);
+	if (state == NULL || state->tic == NULL) {
+		return 0;
+	}
+
+	return tic_core_state_size((tic_mem*)state->tic);
 }
 
 /**
- * libretro callback; Get the current persistent memory.
+ * libretro callback; Snapshot RAM, core state and, when the language allows it, the script VM.
  */
 RETRO_API bool retro_serialize(void *data, size_t size)
 {
-	TIC_UNUSED(size);
 	if (state == NULL || state->tic == NULL || data == NULL) {
 		return false;
 	}
 
 	tic_mem* tic = (tic_mem*)state->tic;
-	u32* udata = (u32*)data;
-	for (u32 i = 0; i < TIC_PERSISTENT_SIZE; i++) {
-		udata[i] = tic->ram->persistent.data[i];
+
+	if (!state->vmStateReported) {
+		state->vmStateReported = true;
+
+		if (!tic_core_state_vm(tic)) {
+			log_cb(RETRO_LOG_WARN, "[TIC-80] The script VM of this cart can't be snapshotted, savestates restore RAM and sound state only.\n");
+		}
 	}
 
-	return true;
+	return tic_core_state_save(tic, data, size);
 }
 
 /**
- * libretro callback; Given the serialized data, load it into the persistent memory.
+ * libretro callback; Restore a snapshot taken by retro_serialize.
  */
 RETRO_API bool retro_unserialize(const void *data, size_t size)
 {
-	if (state == NULL || state->tic == NULL || size != retro_serialize_size() || data == NULL) {
+	if (state == NULL || state->tic == NULL || data == NULL) {
 		return false;
 	}
 
-	tic_mem* tic = (tic_mem*)state->tic;
-	u32* uData = (u32*)data;
-	for (u32 i = 0; i < TIC_PERSISTENT_SIZE; i++) {
-		tic->ram->persistent.data[i] = uData[i];
-	}
-
-	return true;
+	return tic_core_state_load((tic_mem*)state->tic, data, size);
 }
 
 /**
@@ -0,0 +1,506 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// renders music tracks and sfx of a cart to WAV files, every file is
+// rendered by its own core on a pool of threads:
+//   tic80-render cart.tic --music=0,2-3 --sfx=all --stems --out=build/audio
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include <tic80.h>
+#include "api.h"
+#include "cart.h"
+#include "tools.h"
+#include "tic_atomic.h"
+#include "argparse.h"
+#include "system/headless/common.h"
+
+#define TIC80_EXECUTABLE_NAME "tic80-render"
+
+typedef enum
+{
+    JobMusic,
+    JobSfx,
+} JobType;
+
+typedef struct
+{
+    JobType type;
+    s32 index;
+
+    // every channel goes to its own file instead of the mix
+    bool stems;
+
+    s32 files;
+    s32 saved;
+} Job;
+
+static struct
+{
+    const char* cart;
+    const char* music;
+    const char* sfx;
+    const char* out;
+    s32 stems;
+    s32 samplerate;
+    s32 loops;
+    s32 bank;
+    s32 threads;
+
+    tic_cartridge* rom;
+
+    struct
+    {
+        Job* items;
+        s32 count;
+        u32 next;
+    } jobs;
+} state =
+{
+    .samplerate = TIC80_SAMPLERATE,
+    .loops = 1,
+};
+
+typedef struct
+{
+    s16* data;
+    s32 count;
+    s32 size;
+} Samples;
+
+static void addSamples(Samples* samples, const s16* data, s32 count)
+{
+    if(samples->count + count > samples->size)
+    {
+        samples->size = MAX(samples->size * 2, samples->count + count);
+        samples->data = realloc(samples->data, samples->size * sizeof *samples->data);
+    }
+
+    memcpy(samples->data + samples->count, data, count * sizeof *data);
+    samples->count += count;
+}
+
+static void writeLE(FILE* file, u32 value, s32 bytes)
+{
+    for(s32 i = 0; i < bytes; i++)
+        fputc(value >> (i * 8) & 0xff, file);
+}
+
+static bool saveWave(const char* path, const Samples* samples)
+{
+    FILE* file = fopen(path, "wb");
+
+    if(!file)
+        return false;
+
+    enum
+    {
+        Channels = TIC80_SAMPLE_CHANNELS,
+        Bits = TIC80_SAMPLESIZE * BITS_IN_BYTE,
+        Align = Channels * TIC80_SAMPLESIZE,
+    };
+
+    u32 size = samples->count * TIC80_SAMPLESIZE;
+
+    fwrite("RIFF", 4, 1, file);
+    writeLE(file, 36 + size, 4);
+    fwrite("WAVEfmt ", 8, 1, file);
+    writeLE(file, 16, 4);
+    writeLE(file, 1, 2);
+    writeLE(file, Channels, 2);
+    writeLE(file, state.samplerate, 4);
+    writeLE(file, state.samplerate * Align, 4);
+    writeLE(file, Align, 2);
+    writeLE(file, Bits, 2);
+    fwrite("data", 4, 1, file);
+    writeLE(file, size, 4);
+
+#if RETRO_IS_BIG_ENDIAN
+    for(s32 i = 0; i < samples->count; i++)
+        writeLE(file, (u16)samples->data[i], TIC80_SAMPLESIZE);
+#else
+    fwrite(samples->data, TIC80_SAMPLESIZE, samples->count, file);
+#endif
+
+    bool done = ferror(file) == 0;
+    fclose(file);
+
+    return done;
+}
+
+// with the sound buses on, samples holds one entry per channel
+static void renderFrame(tic_mem* tic, Samples* samples)
+{
+    tic_core_tick_start(tic);
+    tic_core_tick_end(tic);
+    tic_core_synth_sound(tic);
+
+    if(tic_core_sound_bus(tic, 0))
+        for(s32 i = 0; i < TIC_SOUND_CHANNELS; i++)
+            addSamples(samples + i, tic_core_sound_bus(tic, i), tic->product.samples.count);
+    else addSamples(samples, tic->product.samples.buffer, tic->product.samples.count);
+}
+
+// every jump back to an earlier frame ends a loop, the same frame limit
+// as the studio export keeps tracks with jump commands from running forever
+static void renderMusic(tic_mem* tic, s32 track, Samples* samples)
+{
+    const tic_music_state* music = &tic->ram->music_state;
+
+    tic_api_music(tic, track, -1, -1, state.loops > 1, false, -1, -1);
+
+    s32 frame = music->music.frame;
+    s32 frames = MUSIC_FRAMES * 16 * state.loops;
+
+    for(s32 loops = 0; frames && music->flag.music_status == tic_music_play;)
+    {
+        s32 count = samples->count;
+        renderFrame(tic, samples);
+
+        if(frame != music->music.frame)
+        {
+            // drop the tick that already started the next loop
+            if(music->music.frame < frame && ++loops == state.loops)
+            {
+                for(s32 i = 0, files = tic_core_sound_bus(tic, 0) ? TIC_SOUND_CHANNELS : 1; i < files; i++)
+                    samples[i].count = count;
+                break;
+            }
+
+            --frames;
+            frame = music->music.frame;
+        }
+    }
+
+    tic_api_music(tic, -1, -1, -1, false, false, -1, -1);
+}
+
+static void renderSfx(tic_mem* tic, s32 index, Samples* samples)
+{
+    enum {Channel = 0};
+    const tic_sample* effect = &tic->ram->sfx.samples.data[index];
+
+    for(s32 loop = 0; loop < state.loops; loop++)
+    {
+        tic_api_sfx(tic, index, effect->note, effect->octave, -1, Channel, MAX_VOLUME, MAX_VOLUME, SFX_DEF_SPEED);
+
+        for(s32 ticks = 0, pos = 0; pos < SFX_TICKS; pos = tic_tool_sfx_pos(effect->speed, ++ticks))
+            renderFrame(tic, samples);
+    }
+
+    tic_api_sfx(tic, -1, 0, 0, -1, Channel, MAX_VOLUME, MAX_VOLUME, SFX_DEF_SPEED);
+}
+
+static void renderJob(Job* job)
+{
+    tic_mem* tic = (tic_mem*)tic80_create(state.samplerate, TIC80_PIXEL_COLOR_RGBA8888);
+
+    memcpy(&tic->cart, state.rom, sizeof(tic_cartridge));
+    tic_api_sync(tic, tic_sync_sfx | tic_sync_music, state.bank, false);
+
+    Samples samples[TIC_SOUND_CHANNELS] = {0};
+
+    if(job->stems)
+        tic80_sound_buses((tic80*)tic, true);
+
+    job->type == JobMusic
+        ? renderMusic(tic, job->index, samples)
+        : renderSfx(tic, job->index, samples);
+
+    tic80_delete((tic80*)tic);
+
+    job->files = job->stems ? TIC_SOUND_CHANNELS : 1;
+
+    for(s32 i = 0; i < job->files; i++)
+    {
+        char path[1024];
+        char stem[16] = "";
+
+        if(job->stems)
+            snprintf(stem, sizeof stem, "-ch%d", i);
+
+        snprintf(path, sizeof path, "%s-%s%02d%s.wav", state.out,
+            job->type == JobMusic ? "music" : "sfx", job->index, stem);
+
+        if(saveWave(path, samples + i))
+        {
+            printf("%s\n", path);
+            job->saved++;
+        }
+        else fprintf(stderr, "can't write %s\n", path);
+
+        free(samples[i].data);
+    }
+}
+
+static void renderJobs()
+{
+    for(u32 index; (index = tic_atomic_add(&state.jobs.next, 1)) < (u32)state.jobs.count;)
+    {
+        Job* job = &state.jobs.items[index];
+        renderJob(job);
+    }
+}
+
+#if defined(_WIN32)
+
+static DWORD WINAPI renderThread(LPVOID data)
+{
+    renderJobs();
+    return 0;
+}
+
+static s32 cpuCount()
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+}
+
+static void runThreads(s32 count)
+{
+    HANDLE* threads = malloc(sizeof(HANDLE) * count);
+
+    for(s32 i = 0; i < count; i++)
+        threads[i] = CreateThread(NULL, 0, renderThread, NULL, 0, NULL);
+
+    renderJobs();
+
+    for(s32 i = 0; i < count; i++)
+        if(threads[i])
+        {
+            WaitForSingleObject(threads[i], INFINITE);
+            CloseHandle(threads[i]);
+        }
+
+    free(threads);
+}
+
+#else
+
+static void* renderThread(void* data)
+{
+    renderJobs();
+    return NULL;
+}
+
+static s32 cpuCount()
+{
+    return (s32)sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+static void runThreads(s32 count)
+{
+    pthread_t* threads = malloc(sizeof(pthread_t) * count);
+    bool* started = calloc(count, sizeof(bool));
+
+    for(s32 i = 0; i < count; i++)
+        started[i] = pthread_create(&threads[i], NULL, renderThread, NULL) == 0;
+
+    renderJobs();
+
+    for(s32 i = 0; i < count; i++)
+        if(started[i])
+            pthread_join(threads[i], NULL);
+
+    free(started);
+    free(threads);
+}
+
+#endif
+
+// an sfx plays on a single channel, so only music is split into stems
+static void addJob(JobType type, s32 index)
+{
+    state.jobs.items = realloc(state.jobs.items, sizeof(Job) * (state.jobs.count + 1));
+    state.jobs.items[state.jobs.count++] = (Job){type, index, state.stems && type == JobMusic};
+}
+
+static bool trackEmpty(s32 index)
+{
+    return EMPTY(state.rom->banks[state.bank].music.tracks.data[index].data);
+}
+
+static bool sfxEmpty(s32 index)
+{
+    const tic_sample* sample = &state.rom->banks[state.bank].sfx.samples.data[index];
+    return tic_tool_empty(sample, sizeof *sample);
+}
+
+// 'all', or a list of indexes and ranges like '0,3-5'
+static bool addJobs(JobType type, const char* list, s32 count, bool(*empty)(s32))
+{
+    if(strcmp(list, "all") == 0)
+    {
+        for(s32 i = 0; i < count; i++)
+            if(!empty(i))
+                addJob(type, i);
+
+        return true;
+    }
+
+    for(const char* ptr = list; *ptr;)
+    {
+        char* end;
+        s32 first = strtol(ptr, &end, 10), last = first;
+
+        if(end == ptr)
+            return false;
+
+        if(*end == '-')
+        {
+            ptr = end + 1;
+            last = strtol(ptr, &end, 10);
+
+            if(end == ptr)
+                return false;
+        }
+
+        if(first < 0 || last >= count || first > last)
+            return false;
+
+        for(s32 i = first; i <= last; i++)
+            addJob(type, i);
+
+        ptr = *end == ',' ? end + 1 : end;
+
+        if(*end && *end != ',')
+            return false;
+    }
+
+    return true;
+}
+
+static void parseArgs(s32 argc, char **argv)
+{
+    static const char *const usage[] =
+    {
+        TIC80_EXECUTABLE_NAME " <cart> [options]",
+        NULL,
+    };
+
+    struct argparse_option options[] =
+    {
+        OPT_HELP(),
+        OPT_STRING('\0', "music", &state.music, "tracks to render, 'all' or a list like '0,2-3'"),
+        OPT_STRING('\0', "sfx", &state.sfx, "sfx to render, 'all' or a list like '0,2-3'"),
+        OPT_STRING('\0', "out", &state.out, "output prefix, files are named <prefix>-music00.wav (cart name by default)"),
+        OPT_BOOLEAN('\0', "stems", &state.stems, "render every music channel to its own file"),
+        OPT_INTEGER('\0', "samplerate", &state.samplerate, "sample rate, a multiple of 60 (44100 by default)"),
+        OPT_INTEGER('\0', "loops", &state.loops, "times to play every track or sfx (1 by default)"),
+        OPT_INTEGER('\0', "bank", &state.bank, "bank to take music and sfx from (0 by default)"),
+        OPT_INTEGER('\0', "threads", &state.threads, "number of threads (number of CPUs by default)"),
+        OPT_END(),
+    };
+
+    struct argparse argparse;
+    argparse_init(&argparse, options, usage, 0);
+    argparse_describe(&argparse, "\n" TIC80_EXECUTABLE_NAME " renders cart music and sfx to WAV files, all of them by default.", NULL);
+    argc = argparse_parse(&argparse, argc, (const char**)argv);
+
+    if(argc == 1)
+        state.cart = argv[0];
+    else
+        argparse_usage(&argparse);
+}
+
+s32 main(s32 argc, char **argv)
+{
+    parseArgs(argc, argv);
+
+    if(!state.cart)
+        return 1;
+
+    // the core takes a whole number of samples per frame
+    if(state.samplerate <= 0 || state.samplerate % TIC80_FRAMERATE != 0
+        || state.loops <= 0 || state.bank < 0 || state.bank >= TIC_BANKS)
+    {
+        fprintf(stderr, "invalid samplerate, loops or bank\n");
+        return 1;
+    }
+
+    s32 size = 0;
+    void* cart = loadCart(state.cart, &size);
+
+    if(!cart)
+    {
+        fprintf(stderr, "can't load cart %s\n", state.cart);
+        return 1;
+    }
+
+    state.rom = calloc(1, sizeof(tic_cartridge));
+    tic_cart_load(state.rom, cart, size);
+    free(cart);
+
+    char prefix[1024];
+    if(!state.out)
+    {
+        snprintf(prefix, sizeof prefix, "%s", state.cart);
+
+        char* ext = strrchr(prefix, '.');
+        if(ext && ext > prefix)
+            *ext = '\0';
+
+        state.out = prefix;
+    }
+
+    if(!state.music && !state.sfx)
+        state.music = state.sfx = "all";
+
+    if((state.music && !addJobs(JobMusic, state.music, MUSIC_TRACKS, trackEmpty))
+        || (state.sfx && !addJobs(JobSfx, state.sfx, SFX_COUNT, sfxEmpty)))
+    {
+        fprintf(stderr, "invalid track or sfx list\n");
+        return 1;
+    }
+
+    s32 threads = CLAMP(state.threads > 0 ? state.threads : cpuCount(), 1, MAX(state.jobs.count, 1));
+
+    u64 start = getCounter();
+
+    // the main thread renders too
+    runThreads(threads - 1);
+
+    s32 saved = 0, failed = 0;
+    for(s32 i = 0; i < state.jobs.count; i++)
+    {
+        saved += state.jobs.items[i].saved;
+        failed += state.jobs.items[i].files - state.jobs.items[i].saved;
+    }
+
+    fprintf(stderr, "%d files, %d threads, %.3f s\n", saved, threads,
+        (double)(getCounter() - start) / getFreq());
+
+    free(state.jobs.items);
+    free(state.rom);
+
+    return failed ? 1 : 0;
+}
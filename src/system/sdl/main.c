@@ -22,6 +22,7 @@
 
 #include "studio/system.h"
 #include "tools.h"
+#include "tic_atomic.h"
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -69,7 +70,16 @@
 #define KBD_COLS 22
 #define KBD_ROWS 17
 
-#define LOCK_MUTEX(MUTEX) SDL_LockMutex(MUTEX); SCOPE(SDL_UnlockMutex(MUTEX))
+#if !defined(AUDIO_LATENCY)
+#define AUDIO_LATENCY 2
+#endif
+
+#if !defined(AUDIO_LOW_LATENCY_SAMPLES)
+#define AUDIO_LOW_LATENCY_SAMPLES 256
+#endif
+
+// samples in the audio ring, a power of two
+enum { AudioRingSize = 1 << 15 };
 
 enum 
 {
@@ -109,6 +119,9 @@ static struct
         u32 shader;
         GPU_ShaderBlock block;
 #endif
+
+        // the window needs the last screen again even if the studio is idle
+        bool redraw;
     } screen;
 
     struct
@@ -178,10 +191,24 @@ static struct
 
     struct
     {
-        SDL_mutex           *mutex;
         SDL_AudioSpec       spec;
         SDL_AudioDeviceID   device;
-        s32                 bufferRemaining;
+
+        // frames of sound queued ahead of the device buffer
+        s32                 latency;
+
+        // single producer (gpuTick) single consumer (audioCallback) ring,
+        // positions are in samples and only grow, they wrap at AudioRingSize
+        struct
+        {
+            s16 samples[AudioRingSize];
+            u32 head;
+            u32 tail;
+        } ring;
+
+        // underruns are counted on the audio thread
+        u32 underruns;
+        u32 overruns;
     } audio;
 } platform
 #if defined(TOUCH_INPUT_SUPPORT)
@@ -281,27 +308,71 @@ static void renderCopy(Renderer render, Texture tex, SDL_Rect src, SDL_Rect dst)
 
 static void audioCallback(void* userdata, u8* stream, s32 len)
 {
-    LOCK_MUTEX(platform.audio.mutex)
+    s16* dst = (s16*)stream;
+    u32 count = len / TIC80_SAMPLESIZE;
+
+    u32 tail = platform.audio.ring.tail;
+    u32 ready = MIN(tic_atomic_load(&platform.audio.ring.head) - tail, count);
+
+    for(u32 i = 0; i < ready; i++)
+        *dst++ = platform.audio.ring.samples[(tail + i) & (AudioRingSize - 1)];
+
+    tic_atomic_store(&platform.audio.ring.tail, tail + ready);
+
+    // underrun, the next frame comes in soon
+    if(ready < count)
+    {
+        memset(dst, 0, (count - ready) * TIC80_SAMPLESIZE);
+        tic_atomic_add(&platform.audio.underruns, 1);
+    }
+}
+
+// synthesizes frames until the ring holds the device buffer and the
+// latency on top of it, so the device clock paces the synth and the
+// register ring absorbs the drift from the frame timer
+static void fillSound()
+{
+    const tic_mem* tic = studio_mem(platform.studio);
+    u32 frame = tic->product.samples.count;
+    u32 target = platform.audio.spec.samples * TIC80_SAMPLE_CHANNELS + platform.audio.latency * frame;
+
+    u32 head = platform.audio.ring.head;
+
+    while(true)
     {
-        const tic_mem* tic = studio_mem(platform.studio);
+        // the callback thread moves the tail
+        u32 tail = tic_atomic_load(&platform.audio.ring.tail);
+
+        if(head - tail >= target)
+            break;
 
-        while(len--)
+        if(head + frame - tail > AudioRingSize)
         {
-            if (platform.audio.bufferRemaining <= 0)
-            {
-                studio_sound(platform.studio);
-                platform.audio.bufferRemaining = tic->product.samples.count * TIC80_SAMPLESIZE;
-            }
+            platform.audio.overruns++;
+            break;
+        }
+
+        studio_sound(platform.studio);
+
+        for(u32 i = 0; i < frame; i++)
+            platform.audio.ring.samples[(head + i) & (AudioRingSize - 1)] = tic->product.samples.buffer[i];
 
-            *stream++ = ((u8*)tic->product.samples.buffer)[tic->product.samples.count * TIC80_SAMPLESIZE - platform.audio.bufferRemaining--];
-        }        
+        tic_atomic_store(&platform.audio.ring.head, head += frame);
     }
+
+    // the device buffer is played after everything queued in the ring
+    u32 queued = head - tic_atomic_load(&platform.audio.ring.tail) + platform.audio.spec.samples * TIC80_SAMPLE_CHANNELS;
+
+    studio_sound_stats(platform.studio, &(tic80_sound_stats)
+    {
+        .delay = queued / frame,
+        .underruns = tic_atomic_load(&platform.audio.underruns),
+        .overruns = platform.audio.overruns,
+    });
 }
 
 static void initSound()
 {
-    platform.audio.mutex = SDL_CreateMutex();
-
     SDL_AudioSpec want =
     {
         .freq = TIC80_SAMPLERATE,
@@ -312,6 +383,13 @@ static void initSound()
         .samples = 1024,
     };
 
+    if(studio_config(platform.studio)->lowLatency)
+    {
+        want.samples = AUDIO_LOW_LATENCY_SAMPLES;
+        platform.audio.latency = 1;
+    }
+    else platform.audio.latency = AUDIO_LATENCY;
+
     platform.audio.device = SDL_OpenAudioDevice(NULL, 0, &want, &platform.audio.spec, 0);
 }
 
@@ -426,7 +504,7 @@ static void initTouchKeyboardState(tic_mem* tic, Texture* texture, void** pixels
 
 static void initTouchKeyboard()
 {
-    tic_mem *tic = tic_core_create(TIC80_SAMPLERATE, SCREEN_FORMAT);
+    tic_mem *tic = tic_core_create(TIC80_SAMPLERATE, SCREEN_FORMAT, TIC80_LATENCY_DEFAULT);
     
     SCOPE(tic_core_close(tic))
     {
@@ -478,7 +556,7 @@ static void initTouchGamepad()
 {
     if(!platform.gamepad.touch.pixels)
     {
-        tic_mem* tic = tic_core_create(TIC80_SAMPLERATE, SCREEN_FORMAT);
+        tic_mem* tic = tic_core_create(TIC80_SAMPLERATE, SCREEN_FORMAT, TIC80_LATENCY_DEFAULT);
         
         SCOPE(tic_core_close(tic))
         {
@@ -1116,6 +1194,8 @@ static void pollEvents()
             }
             break;
         case SDL_WINDOWEVENT:
+            platform.screen.redraw = true;
+
             switch(event.window.event)
             {
             case SDL_WINDOWEVENT_ENTER:
@@ -1697,10 +1777,17 @@ static void gpuTick()
         return;
     }
 
-    LOCK_MUTEX(platform.audio.mutex)
-    {
-        studio_tick(platform.studio, platform.input);
-    }
+    studio_tick(platform.studio, platform.input);
+
+    if(platform.audio.device)
+        fillSound();
+
+    platform.keyboard.text = '\0';
+
+    if(studio_idle(platform.studio) && !platform.screen.redraw)
+        return;
+
+    platform.screen.redraw = false;
 
     renderClear(platform.screen.renderer);
     updateTextureBytes(platform.screen.texture, tic->product.screen, TIC80_FULLWIDTH, TIC80_FULLHEIGHT);
@@ -1767,9 +1854,9 @@ static void gpuTick()
         renderKeyboard();
 #endif
 
+    u64 start = tic_sys_counter_get();
     renderPresent(platform.screen.renderer);
-
-    platform.keyboard.text = '\0';
+    studio_trace(platform.studio, "renderPresent", start, tic_sys_counter_get());
 }
 
 #if defined(__EMSCRIPTEN__)
@@ -1918,8 +2005,18 @@ static s32 start(s32 argc, char **argv, const char* folder)
 
                     s64 delay = (nextTick += Delta) - SDL_GetPerformanceCounter();
 
+                    // an idle studio wakes up as soon as there is an event
                     if(delay > 0)
-                        SDL_Delay((u32)(delay * 1000 / SDL_GetPerformanceFrequency()));
+                    {
+                        u32 ms = (u32)(delay * 1000 / SDL_GetPerformanceFrequency());
+
+                        if(studio_idle(platform.studio))
+                        {
+                            if(SDL_WaitEventTimeout(NULL, ms))
+                                nextTick = SDL_GetPerformanceCounter();
+                        }
+                        else SDL_Delay(ms);
+                    }
                     else if(delay < 0)
                         nextTick = SDL_GetPerformanceCounter();
                 }
@@ -1948,8 +2045,6 @@ static s32 start(s32 argc, char **argv, const char* folder)
                 SDL_DestroyWindow(platform.window);
                 SDL_CloseAudioDevice(platform.audio.device);
             }
-
-            SDL_DestroyMutex(platform.audio.mutex);
         }
     }
 
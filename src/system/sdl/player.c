@@ -35,6 +35,7 @@
 #define TIC80_WINDOW_TITLE "TIC-80"
 #define TIC80_DEFAULT_CART "cart.tic"
 #define TIC80_EXECUTABLE_NAME "player-sdl"
+#define TIC80_REWIND_BUDGET (16 << 20)
 
 static struct
 {
@@ -96,6 +97,8 @@ s32 runCart(void* cart, s32 size)
     }
     else 
     {
+        tic80_rewind_init(tic, TIC80_REWIND_BUDGET);
+
         SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
 
         SDL_Window* window = SDL_CreateWindow(TIC80_WINDOW_TITLE, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, TIC80_FULLWIDTH * TIC80_WINDOW_SCALE, TIC80_FULLHEIGHT * TIC80_WINDOW_SCALE, SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
@@ -174,7 +177,11 @@ s32 runCart(void* cart, s32 size)
 
             SDL_LockMutex(state.mutex);
             {
-                tic80_tick(tic, input, tic_sys_counter_get, tic_sys_freq_get);
+                // hold Backspace to rewind
+                if(SDL_GetKeyboardState(NULL)[SDL_SCANCODE_BACKSPACE])
+                    tic80_rewind(tic);
+                else
+                    tic80_tick(tic, input, tic_sys_counter_get, tic_sys_freq_get);
             }
             SDL_UnlockMutex(state.mutex);
 
@@ -54,7 +54,12 @@ static void onExit(void* data)
 
 tic80* tic80_create(s32 samplerate, tic80_pixel_color_format format)
 {
-    return &tic_core_create(samplerate, format)->product;
+    return tic80_create_ex(samplerate, format, TIC80_LATENCY_DEFAULT);
+}
+
+tic80* tic80_create_ex(s32 samplerate, tic80_pixel_color_format format, tic80_latency latency)
+{
+    return &tic_core_create(samplerate, format, latency)->product;
 }
 
 TIC80_API void tic80_load(tic80* tic, void* cart, s32 size)
@@ -84,8 +89,27 @@ TIC80_API void tic80_tick(tic80* tic, tic80_input input, CounterCallback counter
 
     tic_core_tick_start(mem);
     tic_core_tick(mem, &tickData);
+    tic_core_rewind_push(mem);
+    tic_core_tick_end(mem);
+    tic_core_blit(mem);
+}
+
+TIC80_API void tic80_rewind_init(tic80* tic, s32 budget)
+{
+    tic_mem* mem = (tic_mem*)tic;
+    tic_core_rewind_init(mem, MAX(budget, 0));
+}
+
+TIC80_API bool tic80_rewind(tic80* tic)
+{
+    tic_mem* mem = (tic_mem*)tic;
+
+    tic_core_tick_start(mem);
+    bool done = tic_core_rewind_back(mem);
     tic_core_tick_end(mem);
     tic_core_blit(mem);
+
+    return done;
 }
 
 TIC80_API void tic80_sound(tic80* tic)
@@ -94,6 +118,24 @@ TIC80_API void tic80_sound(tic80* tic)
     tic_core_synth_sound(mem);
 }
 
+TIC80_API tic80_sound_stats tic80_sound_stats_get(tic80* tic)
+{
+    tic_mem* mem = (tic_mem*)tic;
+    return *tic_core_sound_stats(mem);
+}
+
+TIC80_API void tic80_sound_buses(tic80* tic, bool enable)
+{
+    tic_mem* mem = (tic_mem*)tic;
+    tic_core_sound_buses(mem, enable);
+}
+
+TIC80_API const TIC80_SAMPLETYPE* tic80_sound_bus(tic80* tic, s32 channel)
+{
+    tic_mem* mem = (tic_mem*)tic;
+    return tic_core_sound_bus(mem, channel);
+}
+
 TIC80_API void tic80_delete(tic80* tic)
 {
     tic_mem* mem = (tic_mem*)tic;
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <tic80_types.h>
+
+// acquire/release access to a u32 shared by one producer and one consumer
+// thread; the value stays a plain u32, so structs holding it can be copied.
+// tic_atomic_add returns the previous value and is safe between any threads
+
+#if defined(_MSC_VER) && !defined(__clang__)
+
+#include <intrin.h>
+
+static inline u32 tic_atomic_load(const u32* ptr)
+{
+    return (u32)_InterlockedCompareExchange((volatile long*)ptr, 0, 0);
+}
+
+static inline void tic_atomic_store(u32* ptr, u32 value)
+{
+    _InterlockedExchange((volatile long*)ptr, (long)value);
+}
+
+static inline u32 tic_atomic_add(u32* ptr, u32 value)
+{
+    return (u32)_InterlockedExchangeAdd((volatile long*)ptr, (long)value);
+}
+
+#elif defined(__GNUC__) || defined(__clang__)
+
+static inline u32 tic_atomic_load(const u32* ptr)
+{
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+static inline void tic_atomic_store(u32* ptr, u32 value)
+{
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+static inline u32 tic_atomic_add(u32* ptr, u32 value)
+{
+    return __atomic_fetch_add(ptr, value, __ATOMIC_ACQ_REL);
+}
+
+#else
+
+#include <stdatomic.h>
+
+static inline u32 tic_atomic_load(const u32* ptr)
+{
+    return atomic_load_explicit((const _Atomic u32*)ptr, memory_order_acquire);
+}
+
+static inline void tic_atomic_store(u32* ptr, u32 value)
+{
+    atomic_store_explicit((_Atomic u32*)ptr, value, memory_order_release);
+}
+
+static inline u32 tic_atomic_add(u32* ptr, u32 value)
+{
+    return atomic_fetch_add_explicit((_Atomic u32*)ptr, value, memory_order_acq_rel);
+}
+
+#endif
@@ -398,6 +398,10 @@ WASM_IMPORT("tstamp")
 // Returns the current Unix timestamp in seconds.
 uint32_t tstamp();
 
+WASM_IMPORT("cpu")
+// Returns how many milliseconds the game code has taken in this frame so far.
+float cpu();
+
 WASM_IMPORT("trace")
 // Print a string to the Console.
 void trace(const char* text, int8_t color);
\ No newline at end of file
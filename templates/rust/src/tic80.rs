@@ -146,6 +146,7 @@ pub mod sys {
         pub fn sync(mask: i32, bank: u8, to_cart: bool);
         pub fn time() -> f32;
         pub fn tstamp() -> u32;
+        pub fn cpu() -> f32;
         pub fn trace(text: *const u8, color: u8);
         pub fn tri(x1: f32, y1: f32, x2: f32, y2: f32, x3: f32, y3: f32, color: u8);
         pub fn trib(x1: f32, y1: f32, x2: f32, y2: f32, x3: f32, y3: f32, color: u8);
@@ -738,3 +739,7 @@ pub fn time() -> f32 {
 pub fn tstamp() -> u32 {
     unsafe { sys::tstamp() }
 }
+
+pub fn cpu() -> f32 {
+    unsafe { sys::cpu() }
+}
@@ -142,6 +142,7 @@ pub const raw = struct {
     pub extern fn time() f32;
     pub extern fn trace(text: [*:0]const u8, color: i32) void;
     pub extern fn tstamp() u64;
+    pub extern fn cpu() f32;
     pub extern fn vbank(bank: i32) u8;
 };
 
@@ -476,3 +477,4 @@ pub fn sync(args: SyncArgs) void {
 
 pub const time = raw.time;
 pub const tstamp = raw.tstamp;
+pub const cpu = raw.cpu;